@@ -5,11 +5,81 @@
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QStringList>
+#include <QSqlDriver>
+#include <cstring>
+#include <QMutexLocker>
+#include <QTimer>
+#include <QDateTime>
+#include <QAtomicInt>
+#include <QFuture>
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QRegularExpression>
+#include <limits>
+#include <algorithm>
+#include <QTextStream>
+#include <QBuffer>
+#include <QSet>
+#include <sqlite3.h>
+
+QMutex EasySQLite::s_changeMutex;
+QList<EasySQLite*> EasySQLite::s_changeListenerList;
+QHash<sqlite3*,QList<ESChange>> EasySQLite::s_pendingChangeHash;
+QHash<sqlite3*,QList<ESChange>> EasySQLite::s_committingChangeHash;
+QHash<QString,quint64> EasySQLite::s_tableVersionHash;
+quint64 EasySQLite::s_writeEpoch = 0;
+int EasySQLite::s_resultCacheNum = 0;
 
 EasySQLite::EasySQLite(QObject *parent):QObject{parent}{}
 
 EasySQLite::~EasySQLite(){
+    //注销数据变更监听
+    setChangeNotifyEnabled(false);
     delete m_tableModel;
+
+    //注销查询结果缓存 缓存的TableModel随父对象析构
+    if(m_resultCacheSize>0){
+        QMutexLocker locker(&s_changeMutex);
+        s_resultCacheNum--;
+    }
+
+    traceStop();
+
+    //未结束的事务全部回滚
+    while(m_transactionDepth>0&&transactionRollback()){
+    }
+
+    //等待并行读任务结束 关闭读连接池
+    if(m_readPool!=nullptr){
+        m_readPool->waitForDone();
+    }
+    for (int var = 0; var < m_readHandleList.size(); ++var) {
+        sqlite3_close_v2(m_readHandleList.at(var));
+    }
+
+    //关闭并移除本对象的分片连接
+    for (int shardIndex = 0; shardIndex < m_shardPathList.size(); ++shardIndex) {
+        QString connectionName = shardConnectionName(shardIndex);
+        if(QSqlDatabase::contains(connectionName)){
+            QSqlDatabase::database(connectionName,false).close();
+            QSqlDatabase::removeDatabase(connectionName);
+        }
+    }
+
+    //内存模式 析构前完整备份回磁盘 再真正关闭连接
+    if(m_memoryMode){
+        if(!databaseBackup()){
+            qDebug().noquote()<<m_errorInfo;
+        }
+        m_database.close();
+        return;
+    }
     databaseClose();
 }
 
@@ -36,7 +106,34 @@ bool EasySQLite::databaseInit(ESConfig *config){
         if(!QSqlDatabase::contains("qt_sql_default_connection")){
             //未创建过默认连接
             m_database = QSqlDatabase::addDatabase("QSQLITE");
-            m_database.setDatabaseName(config->databasePath());
+            m_busyTimeout = config->busyTimeout();
+            m_busyRetryNum = config->busyRetryNum();
+            m_busyBackoff = config->busyBackoff();
+            m_busyBackoffMax = config->busyBackoffMax();
+            if(config->memoryMode()){
+                //内存模式 使用共享缓存内存数据库 便于同进程其它连接访问
+                m_memoryMode = true;
+                m_diskPath = config->databasePath();
+                m_backupStepPages = config->backupStepPages();
+                //内存库名由磁盘路径导出 不同磁盘文件的内存库互不共用
+                QString memoryName = QString::number(qHash(QFileInfo(m_diskPath).absoluteFilePath()),16);
+                m_database.setDatabaseName(QString("file:easysqlite_memory_%1?mode=memory&cache=shared").arg(memoryName));
+                m_database.setConnectOptions("QSQLITE_OPEN_URI");
+            }else if(config->readOnlyMode()){
+                //只读模式 immutable时用URI打开 路径中的URI保留字符需转义
+                m_readOnlyMode = true;
+                if(config->immutable()){
+                    QString path = QFileInfo(config->databasePath()).absoluteFilePath();
+                    path.replace("%","%25").replace("?","%3f").replace("#","%23");
+                    m_database.setDatabaseName("file:" + path + "?immutable=1");
+                    m_database.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_OPEN_URI");
+                }else{
+                    m_database.setDatabaseName(config->databasePath());
+                    m_database.setConnectOptions("QSQLITE_OPEN_READONLY");
+                }
+            }else{
+                m_database.setDatabaseName(config->databasePath());
+            }
         }else{
             //默认连接已存在
             m_errorInfo = "[EasySQLite/Error]数据库初始化报错: 默认连接已存在";
@@ -44,6 +141,41 @@ bool EasySQLite::databaseInit(ESConfig *config){
         }
     }
 
+    //记录初始化配置 开始轨迹记录时写入文件头
+    if(config!=nullptr){
+        m_traceConfig = traceConfigSave(config);
+    }
+
+    //启用查询结果缓存 在打开前登记 打开时即注册update钩子跟踪写入
+    if(config!=nullptr&&config->resultCacheSize()>0&&m_resultCacheSize<=0){
+        m_resultCacheSize = config->resultCacheSize();
+        m_resultCacheStats.memoryBudget = m_resultCacheSize;
+        QMutexLocker locker(&s_changeMutex);
+        s_resultCacheNum++;
+    }
+
+    //钩子/增量BLOB/在线备份/锁等待直接对驱动的连接句柄调用SQLite C API
+    //要求Qt以-system-sqlite编译 驱动与本程序使用同一个libsqlite3 驱动内置SQLite时在使用C API前拒绝
+    bool isOpened = m_database.isOpen();
+    if(!isOpened&&!m_database.open()){
+        m_errorInfo = "[EasySQLite/Error]数据库初始化报错: " + m_database.lastError().text();
+        return false;
+    }
+    QSqlQuery versionQuery;
+    bool isVersionQueried = versionQuery.exec("SELECT sqlite_version(),sqlite_source_id()")&&versionQuery.next();
+    QString driverVersion = isVersionQueried?versionQuery.value(0).toString():QString();
+    QString driverSourceId = isVersionQueried?versionQuery.value(1).toString():QString();
+    versionQuery.finish();
+    if(!isOpened){
+        m_database.close();
+    }
+    if(!isVersionQueried||driverVersion!=QString::fromLatin1(sqlite3_libversion())
+        ||driverSourceId!=QString::fromLatin1(sqlite3_sourceid())){
+        m_errorInfo = QString("[EasySQLite/Error]数据库初始化报错: Qt的SQLite驱动(%1)与链接的libsqlite3(%2)不是同一个 需以-system-sqlite编译Qt")
+                          .arg(driverVersion,QString::fromLatin1(sqlite3_libversion()));
+        return false;
+    }
+
     //已连接 打开本地数据库
     if(!databaseOpen()){
         //打开失败
@@ -51,6 +183,57 @@ bool EasySQLite::databaseInit(ESConfig *config){
         return false;
     }
 
+    //只读模式 设置连接参数后直接返回 跳过建表/索引/维护等写路径初始化 连接保持常开
+    if(m_readOnlyMode){
+        QSqlQuery query;
+        m_mmapSize = config->mmapSize();
+        if(!query.exec(QString("PRAGMA mmap_size = %1").arg(m_mmapSize))||!query.exec("PRAGMA query_only = ON")){
+            m_errorInfo = "[EasySQLite/Error]数据库初始化报错: 只读模式设置失败" + query.lastError().text();
+            return false;
+        }
+        if(config->readPoolSize()>0){
+            m_readPoolSize = config->readPoolSize();
+            m_readPool = new QThreadPool(this);
+            m_readPool->setMaxThreadCount(m_readPoolSize);
+            m_readPool->setExpiryTimeout(-1);
+        }
+        qDebug().noquote()<<"[EasySQLite/Info]数据库初始化: 只读模式"<<m_database.databaseName();
+        return true;
+    }
+
+    //内存模式 先从磁盘文件加载工作集 再启动定期备份
+    if(m_memoryMode){
+        if(!memoryLoad()){
+            //加载失败
+            return false;
+        }
+        if(config->backupInterval()>0){
+            m_backupTimer = new QTimer(this);
+            connect(m_backupTimer,&QTimer::timeout,this,[this](){
+                //上一次增量备份未完成时跳过
+                if(m_backup==nullptr&&backupBegin()){
+                    backupSlice();
+                }
+            });
+            m_backupTimer->start(config->backupInterval());
+        }
+    }
+
+    //启用后台维护 新建的数据库文件以INCREMENTAL方式回收空闲页
+    //已有数据库需手动VACUUM一次后auto_vacuum才生效 在此之前维护时跳过增量清理
+    if(config!=nullptr&&config->maintenanceInterval()>0){
+        QSqlQuery query;
+        query.exec("PRAGMA auto_vacuum = INCREMENTAL");
+        m_maintenanceIdle = config->maintenanceIdle();
+        m_maintenanceSlice = config->maintenanceSlice();
+        m_walTruncateSize = config->walTruncateSize();
+        m_maintenanceTimer = new QTimer(this);
+        connect(m_maintenanceTimer,&QTimer::timeout,this,[this](){
+            maintenanceSlice();
+        });
+        m_maintenanceTimer->start(config->maintenanceInterval());
+    }
+
     //打开成功 查询数据库中表格数量
     int tableNum;
     //法1 直接用tables()
@@ -130,6 +313,116 @@ bool EasySQLite::databaseInit(ESConfig *config){
         //     }
         // }
     }
+
+    //根据配置结构体建立索引 已存在时跳过
+    if(config!=nullptr){
+        QSqlQuery query;
+        for (int indexNo = 0; indexNo < config->indexNum(); ++indexNo) {
+            if(!queryExec(query,config->createIndexSql(indexNo))){
+                m_errorInfo = "[EasySQLite/Error]数据库初始化报错: 索引创建失败" + query.lastError().text();
+                return false;
+            }
+        }
+    }
+
+    //启用并行读连接池 主库切换为WAL模式 读连接与写连接互不阻塞
+    if(config!=nullptr&&config->readPoolSize()>0){
+        if(!m_memoryMode){
+            QSqlQuery query;
+            if(!query.exec("PRAGMA journal_mode=WAL")){
+                m_errorInfo = "[EasySQLite/Error]数据库初始化报错: 设置WAL模式错误" + query.lastError().text();
+                return false;
+            }
+        }
+        m_readPoolSize = config->readPoolSize();
+        m_readPool = new QThreadPool(this);
+        m_readPool->setMaxThreadCount(m_readPoolSize);
+        m_readPool->setExpiryTimeout(-1);
+    }
+
+    //根据配置结构体初始化全文检索影子表
+    if(config!=nullptr){
+        QHash<QString,QStringList> searchFieldHash;
+        QStringList searchTableList;
+        for (int fieldIndex = 0; fieldIndex < config->searchFieldNum(); ++fieldIndex) {
+            QString tableName = config->searchTablename(fieldIndex);
+            if(!searchTableList.contains(tableName)){
+                searchTableList.append(tableName);
+            }
+            searchFieldHash[tableName].append(config->searchFieldname(fieldIndex));
+        }
+        for (int tableIndex = 0; tableIndex < searchTableList.size(); ++tableIndex) {
+            if(!searchTableInit(searchTableList.at(tableIndex),searchFieldHash.value(searchTableList.at(tableIndex)))){
+                //影子表初始化失败
+                return false;
+            }
+        }
+    }
+
+    //根据配置结构体初始化物化聚合表
+    if(config!=nullptr){
+        for (int tableIndex = 0; tableIndex < config->aggregateTableNum(); ++tableIndex) {
+            if(!aggregateTableInit(config->aggregateTablename(tableIndex),config->aggregateSourcename(tableIndex),
+                                    config->aggregateGroupFields(tableIndex),config->aggregateSumFields(tableIndex))){
+                //聚合表初始化失败
+                return false;
+            }
+        }
+    }
+
+    //根据配置结构体初始化分片表
+    if(config!=nullptr){
+        for (int tableIndex = 0; tableIndex < config->shardedTableNum(); ++tableIndex) {
+            //补齐分片文件路径
+            for (int shardIndex = m_shardPathList.size(); shardIndex < config->shardNum(tableIndex); ++shardIndex) {
+                m_shardPathList.append(QString("%1.shard%2").arg(config->databasePath()).arg(shardIndex));
+            }
+            if(!shardTableInit(config->shardedTablename(tableIndex),config->shardedDefinition(tableIndex),config->shardNum(tableIndex))){
+                //分片表初始化失败
+                return false;
+            }
+        }
+    }
+
+    //根据配置结构体登记压缩字段
+    if(config!=nullptr){
+        for (int fieldIndex = 0; fieldIndex < config->compressedFieldNum(); ++fieldIndex) {
+            m_compressHash[config->compressedTablename(fieldIndex)].insert(config->compressedFieldname(fieldIndex),
+                                                                           config->compressThreshold(fieldIndex));
+        }
+    }
+
+    //根据配置结构体登记过期字段 启动后台清理
+    if(config!=nullptr&&config->ttlNum()>0){
+        for (int ttlIndex = 0; ttlIndex < config->ttlNum(); ++ttlIndex) {
+            if(!ttlTableInit(config->ttlTablename(ttlIndex),config->ttlFieldname(ttlIndex),config->ttlSecs(ttlIndex))){
+                //过期字段登记失败
+                return false;
+            }
+        }
+        m_ttlPurgeBatch = config->ttlPurgeBatch();
+        m_ttlTimer = new QTimer(this);
+        connect(m_ttlTimer,&QTimer::timeout,this,[this](){
+            //上一轮清理未完成时跳过
+            if(!m_isTTLPurging){
+                ttlPurgeSlice();
+            }
+        });
+        m_ttlTimer->start(config->ttlPurgeInterval());
+    }
+
+    //根据配置结构体初始化分区表
+    if(config!=nullptr){
+        for (int tableIndex = 0; tableIndex < config->partitionedTableNum(); ++tableIndex) {
+            if(!partitionTableInit(config->partitionedTablename(tableIndex),config->partitionedDefinition(tableIndex),
+                                    config->partitionFieldname(tableIndex),config->partitionPeriod(tableIndex),
+                                    config->partitionRetention(tableIndex))){
+                //分区表初始化失败
+                return false;
+            }
+        }
+    }
+
     //打印成功 关闭数据库
     databaseClose();
     //初始化成功
@@ -147,7 +440,13 @@ bool EasySQLite::databaseOpen(){
         m_errorInfo = "[EasySQLite/Error]数据库打开报错: " + m_database.lastError().text();
         return false;
     }
-    //打开成功
+    //每次打开都是新连接 重新设置锁等待 以busy处理函数代替busy_timeout 以便统计等待
+    sqlite3* handle = sqliteHandle(m_database);
+    if(handle!=nullptr){
+        sqlite3_busy_handler(handle,busyHandlerCallback,this);
+    }
+    //打开成功 注册数据变更钩子
+    hookInstall();
     return true;
 }
 
@@ -157,6 +456,15 @@ bool EasySQLite::databaseOpen(){
  *  @retval 无
  */
 void EasySQLite::databaseClose(){
+    //内存模式 关闭连接会丢失数据 保持连接常开
+    //事务进行中 关闭连接会回滚事务 保持连接常开
+    //只读模式 连接参数只对本次连接有效 保持连接常开
+    //先投递已提交的变更 连接关闭后句柄失效
+    changeCommitResolve(sqliteHandle(m_database));
+
+    if(m_memoryMode||m_readOnlyMode||m_transactionDepth>0){
+        return;
+    }
     m_database.close();
 }
 
@@ -182,7 +490,7 @@ bool EasySQLite::tableCreate(const QString& tableName,const QString& definition)
 
     //已指定主键 开始建表
     QSqlQuery query;
-    if(!query.exec(QString("CREATE TABLE %1(%2)").arg(tableName).arg(definition))){
+    if(!queryExec(query,QString("CREATE TABLE %1(%2)").arg(tableName).arg(definition))){
         //建表失败
         m_errorInfo = "[EasySQLite/Error]表格创建报错: 执行SQL语句建表错误" + query.lastError().text();
         return false;
@@ -201,7 +509,7 @@ bool EasySQLite::tableInsert(const QString &tableName, const QString &recordValu
 
     //表格存在 开始插入数据
     QSqlQuery query;
-    if(!query.exec(QString("INSERT INTO %1 VALUES(%2)").arg(tableName).arg(recordValues))){
+    if(!queryExec(query,QString("INSERT INTO %1 VALUES(%2)").arg(tableName).arg(recordValues))){
         //插入失败
         m_errorInfo = "[EasySQLite/Error]表格插入报错: 执行SQL语句插入数据错误" + query.lastError().text();
         return false;
@@ -249,7 +557,7 @@ bool EasySQLite::tablePrint(const QString& tableName){
     qDebug().noquote()<<"-------------------------------------";
 
     //查询数据
-    if(!query.exec(QString("SELECT * FROM %1").arg(tableName))){
+    if(!queryExec(query,QString("SELECT * FROM %1").arg(tableName))){
         //查询失败
         m_errorInfo = "[EasySQLite/Error]表格打印报错: 执行SQL语句查询数据错误" + query.lastError().text();
         return false;
@@ -352,7 +660,7 @@ QString EasySQLite::singleConditionCreate(const QString& tableName,const Conditi
     }
 
     //数据库已打开 判断表格是否存在
-    if (!m_database.tables().contains(tableName)) {
+    if (!m_database.tables().contains(tableName)&&!m_shardNumHash.contains(tableName)&&!m_partitionHash.contains(tableName)) {
         //表格不存在
         m_errorInfo = "[EasySQLite/Error]单个条件创建报错: 表格不存在";
         return "";
@@ -405,6 +713,29 @@ QString EasySQLite::singleConditionCreate(const QString& tableName,const Conditi
     case Condition::NotLikeEnd://not like '%v'
         ret = condiFieldName + " not like '%"+condiFieldValue.toString()+"'";
         break;
+    case Condition::Contains://like '%v%'
+        ret = condiFieldName + " like '%"+condiFieldValue.toString()+"%'";
+        break;
+    case Condition::NotContains://not like '%v%'
+        ret = condiFieldName + " not like '%"+condiFieldValue.toString()+"%'";
+        break;
+    }
+
+    //全文检索字段 后缀/子串条件改走FTS5索引 值中含LIKE通配符%或_时MATCH无法等价 保持LIKE
+    QString searchValue = condiFieldValue.toString();
+    if(m_searchFieldHash.value(tableName).contains(condiFieldName)&&!searchValue.contains('%')&&!searchValue.contains('_')){
+        switch (condition) {
+        case Condition::LikeEnd:
+        case Condition::NotLikeEnd:
+        case Condition::Contains:
+        case Condition::NotContains:
+            ret = searchConditionCreate(tableName,condition==Condition::LikeEnd||condition==Condition::NotLikeEnd,
+                                        condition==Condition::NotLikeEnd||condition==Condition::NotContains,
+                                        condiFieldName,searchValue);
+            break;
+        default:
+            break;
+        }
     }
 
     //创建完成 关闭数据库
@@ -424,7 +755,7 @@ QString EasySQLite::singleConditionCreate(const QString& tableName,const Conditi
     }
 
     //数据库已打开 判断表格是否存在
-    if (!m_database.tables().contains(tableName)) {
+    if (!m_database.tables().contains(tableName)&&!m_shardNumHash.contains(tableName)&&!m_partitionHash.contains(tableName)) {
         //表格不存在
         m_errorInfo = "[EasySQLite/Error]单个条件创建报错: 表格不存在";
         return "";
@@ -516,6 +847,17 @@ QString EasySQLite::primarykeyName(const QString &tableName){
 }
 
 bool EasySQLite::isFieldNameMatch(const QString& tableName, const QString& fieldName, bool& isMatch){
+    //分片表 使用初始化时缓存的字段名
+    if(m_shardNumHash.contains(tableName)){
+        isMatch = m_shardFieldNameHash.value(tableName).contains(fieldName);
+        return true;
+    }
+    //分区表 使用初始化时缓存的字段名
+    if(m_partitionHash.contains(tableName)){
+        isMatch = m_partitionHash[tableName].fieldNameList.contains(fieldName);
+        return true;
+    }
+
     //默认数据库已打开 判断表格是否存在
     if (!m_database.tables().contains(tableName)) {
         m_errorInfo = "[EasySQLite/Error]查询字段名是否存在报错: 表格不存在";
@@ -526,7 +868,7 @@ bool EasySQLite::isFieldNameMatch(const QString& tableName, const QString& field
     QSqlQuery query;
     if(!query.exec(QString("PRAGMA TABLE_INFO(%1)").arg(tableName))){
         //查询失败
-        m_errorInfo = "[EasySQLite/Error]查询字段名是否存在报错: 执行SQL语句查询表格信息错误";
+        m_errorInfo = "[EasySQLite/Error]查询字段名是否存在报错: 执行SQL语句查询表格信息错误" + query.lastError().text();
         return false;
     }
 
@@ -541,6 +883,35 @@ bool EasySQLite::isFieldNameMatch(const QString& tableName, const QString& field
     return true;
 }
 
+/*
+ *  @brief  一次性查询表格的全部字段名
+ *  @param  表格名
+ *  @param  字段名列表(输出)
+ *  @retval 是否查询成功
+ */
+bool EasySQLite::fieldNameQuery(const QString &tableName, QStringList &fieldNameList){
+    //默认数据库已打开 判断表格是否存在
+    if (!m_database.tables().contains(tableName)) {
+        m_errorInfo = "[EasySQLite/Error]查询字段名列表报错: 表格不存在";
+        return false;
+    }
+
+    //表格存在 开始查询
+    QSqlQuery query;
+    if(!query.exec(QString("PRAGMA TABLE_INFO(%1)").arg(tableName))){
+        //查询失败
+        m_errorInfo = "[EasySQLite/Error]查询字段名列表报错: 执行SQL语句查询表格信息错误" + query.lastError().text();
+        return false;
+    }
+
+    //查询成功
+    fieldNameList.clear();
+    while(query.next()){
+        fieldNameList.append(query.value(1).toString());
+    }
+    return true;
+}
+
 bool EasySQLite::isFieldValueMatch(const QString &tableName, const QString &fieldName, const QVariant &fieldValue, bool& isMatch){
     //默认数据库已打开 判断表格是否存在
     if (!m_database.tables().contains(tableName)) {
@@ -563,20 +934,17 @@ bool EasySQLite::isFieldValueMatch(const QString &tableName, const QString &fiel
         return false;
     }
 
-    //字段名存在
+    //字段名存在 由SQLite按条件查找 有索引时不扫描全表
     QSqlQuery query;
-    if(!query.exec(QString("SELECT %1 FROM %2"))){
+    query.prepare(QString("SELECT 1 FROM %1 WHERE %2 = ? LIMIT 1").arg(tableName,fieldName));
+    query.addBindValue(fieldValue);
+    if(!queryExec(query)){
         m_errorInfo = "[EasySQLite/Error]查询字段值是否存在报错:: 执行SQL语句查询数据错误" + query.lastError().text();
         return false;
     }
 
     //判断
-    isMatch = false;
-    while(query.next()){
-        if(query.value(0)==fieldValue){
-            isMatch = true;
-        }
-    }
+    isMatch = query.next();
 
     //执行成功
     return true;
@@ -603,6 +971,23 @@ bool EasySQLite::isFieldValueMatch(const QString &tableName, const QString &fiel
  *  @retval 是否插入成功
  */
 bool EasySQLite::recordInsert(const QString& tableName,const QVariantList& values){
+    TraceScope trace(this,TraceMethod::RecordInsert,tableName,values);
+
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("整行记录插入")){
+        return false;
+    }
+
+    //分区表 路由到时间字段所在分区
+    if(m_partitionHash.contains(tableName)){
+        return partitionRecordInsert(tableName,QList<QVariantList>{values});
+    }
+
+    //分片表 路由到主键所在分片
+    if(m_shardNumHash.contains(tableName)){
+        return shardRecordInsert(tableName,QList<QVariantList>{values});
+    }
+
     //检查数据库是否打开
     if(!m_database.isOpen()){
         //未打开 执行打开数据库
@@ -620,19 +1005,19 @@ bool EasySQLite::recordInsert(const QString& tableName,const QVariantList& value
         return false;
     }
 
-    //表格存在 准备将数据转为sql格式
-    QString strValues = values2SqlFormat(values);
+    //表格存在 准备将数据转为sql格式 压缩字段先压缩
+    QString strValues = compressedValues2SqlFormat(tableName,values);
 
     //开始插入数据
     QSqlQuery query;
-    if(!query.exec(QString("INSERT INTO %1 VALUES(%2)").arg(tableName).arg(strValues))){
+    if(!queryExec(query,QString("INSERT INTO %1 VALUES(%2)").arg(tableName).arg(strValues))){
         //插入失败
         m_errorInfo = "[EasySQLite/Error]整行记录插入报错: 执行SQL语句插入数据错误" + query.lastError().text();
         return false;
     }
 
     //select * from tableName 赋值变量model
-    if(!recordSelectTableAll(tableName)){
+    if(!tableModelRefresh(tableName)){
         //查询失败
         m_errorInfo = "[EasySQLite/Error]整行记录插入报错: 查询TableModel错误";
         return false;
@@ -650,6 +1035,23 @@ bool EasySQLite::recordInsert(const QString& tableName,const QVariantList& value
  *  @retval 是否插入成功
  */
 bool EasySQLite::recordsInsert(const QString& tableName,const QList<QVariantList>& valuesList){
+    TraceScope trace(this,TraceMethod::RecordsInsert,tableName,valuesList);
+
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("多行记录插入")){
+        return false;
+    }
+
+    //分区表 按时间字段分组写入各分区
+    if(m_partitionHash.contains(tableName)){
+        return partitionRecordInsert(tableName,valuesList);
+    }
+
+    //分片表 按分片分组并行写入
+    if(m_shardNumHash.contains(tableName)){
+        return shardRecordInsert(tableName,valuesList);
+    }
+
     //检查数据库是否打开
     if(!m_database.isOpen()){
         //未打开 执行打开数据库
@@ -667,12 +1069,20 @@ bool EasySQLite::recordsInsert(const QString& tableName,const QList<QVariantList
     }
 
     //表格存在 准备将数据转为sql格式
-    QStringList strValuesList = valuesList2SqlFormat(valuesList);
+    QStringList strValuesList;
+    if(m_compressHash.contains(tableName)){
+        //压缩字段先压缩
+        for (int var = 0; var < valuesList.size(); ++var) {
+            strValuesList.append(compressedValues2SqlFormat(tableName,valuesList.at(var)));
+        }
+    }else{
+        strValuesList = valuesList2SqlFormat(valuesList);
+    }
 
     //开始插入数据
     QSqlQuery query;
     for (int recordIndex = 0; recordIndex < strValuesList.size(); ++recordIndex) {
-        if(!query.exec(QString("INSERT INTO %1 VALUES(%2)").arg(tableName).arg(strValuesList.at(recordIndex)))){
+        if(!queryExec(query,QString("INSERT INTO %1 VALUES(%2)").arg(tableName).arg(strValuesList.at(recordIndex)))){
             //插入失败
             m_errorInfo = "[EasySQLite/Error]多行记录插入报错: 执行SQL语句插入数据错误" + query.lastError().text();
             return false;
@@ -680,7 +1090,7 @@ bool EasySQLite::recordsInsert(const QString& tableName,const QList<QVariantList
     }
 
     //select * from tableName 赋值变量model
-    if(!recordSelectTableAll(tableName)){
+    if(!tableModelRefresh(tableName)){
         //查询失败
         m_errorInfo = "[EasySQLite/Error]多行记录插入报错: 查询TableModel错误";
         return false;
@@ -692,6 +1102,24 @@ bool EasySQLite::recordsInsert(const QString& tableName,const QList<QVariantList
 }
 
 bool EasySQLite::recordDelete(const QString& tableName,const QVariant& primarykeyValue){
+    TraceScope trace(this,TraceMethod::RecordDelete,tableName,primarykeyValue);
+
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("整行记录删除")){
+        return false;
+    }
+
+    //分区表只追加 按分区整体删除
+    if(m_partitionHash.contains(tableName)){
+        m_errorInfo = "[EasySQLite/Error]整行记录删除报错: 分区表只允许追加 请用partitionDrop按分区删除";
+        return false;
+    }
+
+    //分片表 路由到主键所在分片
+    if(m_shardNumHash.contains(tableName)){
+        return shardRecordDelete(tableName,QVariantList{primarykeyValue});
+    }
+
     //检查数据库是否打开
     if(!m_database.isOpen()){
         //未打开 执行打开数据库
@@ -735,14 +1163,14 @@ bool EasySQLite::recordDelete(const QString& tableName,const QVariant& primaryke
 
     //开始删除记录
     QSqlQuery query;
-    if(!query.exec(QString("DELETE FROM %1 WHERE %2 = %3").arg(tableName).arg(primaryKeyName).arg(strPrimarykeyValue))){
+    if(!queryExec(query,QString("DELETE FROM %1 WHERE %2 = %3").arg(tableName).arg(primaryKeyName).arg(strPrimarykeyValue))){
         //删除失败
         m_errorInfo = "[EasySQLite/Error]整行记录删除报错: 执行SQL语句删除记录错误" + query.lastError().text();
         return false;
     }
 
     //select * from tableName赋值变量 model
-    if(!recordSelectTableAll(tableName)){
+    if(!tableModelRefresh(tableName)){
         //查询失败
         m_errorInfo = "[EasySQLite/Error]整行记录删除报错: 查询TableModel错误";
         return false;
@@ -754,6 +1182,24 @@ bool EasySQLite::recordDelete(const QString& tableName,const QVariant& primaryke
 }
 
 bool EasySQLite::recordsDelete(const QString &tableName, const QVariantList &primarykeyValueList){
+    TraceScope trace(this,TraceMethod::RecordsDelete,tableName,primarykeyValueList);
+
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("多行记录删除")){
+        return false;
+    }
+
+    //分区表只追加 按分区整体删除
+    if(m_partitionHash.contains(tableName)){
+        m_errorInfo = "[EasySQLite/Error]多行记录删除报错: 分区表只允许追加 请用partitionDrop按分区删除";
+        return false;
+    }
+
+    //分片表 按分片分组并行删除
+    if(m_shardNumHash.contains(tableName)){
+        return shardRecordDelete(tableName,primarykeyValueList);
+    }
+
     //检查数据库是否打开
     if(!m_database.isOpen()){
         //未打开 执行打开数据库
@@ -805,7 +1251,7 @@ bool EasySQLite::recordsDelete(const QString &tableName, const QVariantList &pri
     //开始删除数据
     QSqlQuery query;
     for (int var = 0; var < strPrimarykeyValueList.size(); ++var) {
-        if(!query.exec(QString("DELETE FROM %1 WHERE %2 = %3").arg(tableName).arg(primaryKeyName).arg(strPrimarykeyValueList.at(var)))){
+        if(!queryExec(query,QString("DELETE FROM %1 WHERE %2 = %3").arg(tableName).arg(primaryKeyName).arg(strPrimarykeyValueList.at(var)))){
             //删除失败
             m_errorInfo = "[EasySQLite/Error]多行记录删除报错: 执行SQL语句删除记录错误" + query.lastError().text();
             return false;
@@ -813,7 +1259,7 @@ bool EasySQLite::recordsDelete(const QString &tableName, const QVariantList &pri
     }
 
     //select * from tableName 赋值变量model
-    if(!recordSelectTableAll(tableName)){
+    if(!tableModelRefresh(tableName)){
         //查询失败
         m_errorInfo = "[EasySQLite/Error]多行记录删除报错: 查询TableModel错误";
         return false;
@@ -825,6 +1271,24 @@ bool EasySQLite::recordsDelete(const QString &tableName, const QVariantList &pri
 }
 
 bool EasySQLite::recordSelectTableAll(const QString &tableName){
+    TraceScope trace(this,TraceMethod::RecordSelectTableAll,tableName);
+
+    //分区表 合并全部分区 按时间字段排序
+    if(m_partitionHash.contains(tableName)){
+        const Partition& partition = m_partitionHash[tableName];
+        return partitionRecordSelect(tableName,partition.fieldNameList,"",partition.timeFieldName,SortPolicy::ASC);
+    }
+
+    //分片表 扇出到所有分片 按主键归并 结果不写入TableModel 明确报错以免调用方读到上一次的TableModel
+    if(m_shardNumHash.contains(tableName)){
+        if(!shardRecordSelect(tableName,m_shardFieldNameHash.value(tableName),"",
+                               m_shardPrimarykeyHash.value(tableName),SortPolicy::ASC)){
+            return false;
+        }
+        m_errorInfo = "[EasySQLite/Error]表格全查询报错: 分片表结果不写入TableModel 请通过shardRecords()获取";
+        return false;
+    }
+
     //检查数据库是否打开
     if(!m_database.isOpen()){
         //未打开 执行打开数据库
@@ -843,15 +1307,14 @@ bool EasySQLite::recordSelectTableAll(const QString &tableName){
 
     //表格存在 开始查询
     QSqlQuery query;
-    if(!query.exec(QString("SELECT * FROM %1").arg(tableName))){
+    if(!queryExec(query,QString("SELECT * FROM %1").arg(tableName))){
         //查询失败
         m_errorInfo = "[EasySQLite/Error]表格全查询报错: 执行SQL语句查询表格错误" + query.lastError().text();
         return false;
     }
 
     //select * from tableName 赋值变量model
-    m_tableModel= new QSqlTableModel(this,m_database);
-    m_tableModel->setQuery(query);
+    m_tableModel= tableModelCreate(tableName,query);
 
     //查询成功 关闭数据库
     databaseClose();
@@ -860,6 +1323,22 @@ bool EasySQLite::recordSelectTableAll(const QString &tableName){
 
 bool EasySQLite::recordSelect(const QString &tableName, const QStringList &fieldNameList, const QString& condition,
                               const QString &sortFieldName, const SortPolicy &sortPolicy){
+    TraceScope trace(this,TraceMethod::RecordSelect,tableName,fieldNameList,condition,sortFieldName,sortPolicy);
+
+    //分区表 只查询与时间范围重叠的分区
+    if(m_partitionHash.contains(tableName)){
+        return partitionRecordSelect(tableName,fieldNameList,condition,sortFieldName,sortPolicy);
+    }
+
+    //分片表 扇出到所有分片 按排序字段归并 结果不写入TableModel 明确报错以免调用方读到上一次的TableModel
+    if(m_shardNumHash.contains(tableName)){
+        if(!shardRecordSelect(tableName,fieldNameList,condition,sortFieldName,sortPolicy)){
+            return false;
+        }
+        m_errorInfo = "[EasySQLite/Error]记录查询报错: 分片表结果不写入TableModel 请通过shardRecords()获取";
+        return false;
+    }
+
     //检查数据库是否打开
     if(!m_database.isOpen()){
         //未打开 执行打开数据库
@@ -876,6 +1355,21 @@ bool EasySQLite::recordSelect(const QString &tableName, const QStringList &field
         return false;
     }
 
+    //查询结果缓存 依赖表格未被写入且TableModel尚未经tableModel()交出时直接复用
+    QString cacheKey;
+    QList<quint64> versionList;
+    if(isResultCacheable()){
+        cacheKey = QString("M|SELECT %1 FROM %2 WHERE %3 ORDER BY %4 %5").arg(fieldNameList.join(","),tableName,condition,sortFieldName)
+                       .arg(sortPolicy==SortPolicy::ASC?"ASC":"DESC").simplified();
+        versionList = resultCacheVersions(tableName,condition);
+        ResultCacheEntry* entry = resultCacheFind(cacheKey,versionList);
+        if(entry!=nullptr){
+            m_tableModel = entry->model;
+            databaseClose();
+            return true;
+        }
+    }
+
     //判断查询字段名是否存在 拼接查询字段名
     QString fieldName;
     for (int var = 0; var < fieldNameList.size(); ++var) {
@@ -925,14 +1419,38 @@ bool EasySQLite::recordSelect(const QString &tableName, const QStringList &field
 
     //执行查询
     QSqlQuery query;
-    if(!query.exec(QString("SELECT %1 FROM %2 %3 ORDER BY %4 %5").arg(fieldName).arg(tableName).arg(strCondition).arg(sortFieldName).arg(policy))){
-        m_errorInfo = "[EasySQLite/Error]记录查询报错: 执行SQL语句查询错误";
+    if(!queryExec(query,QString("SELECT %1 FROM %2 %3 ORDER BY %4 %5").arg(fieldName).arg(tableName).arg(strCondition).arg(sortFieldName).arg(policy))){
+        m_errorInfo = "[EasySQLite/Error]记录查询报错: 执行SQL语句查询错误" + query.lastError().text();
         return false;
     }
 
     //查询成功 赋值变量model
-    m_tableModel= new QSqlTableModel(this,m_database);
-    m_tableModel->setQuery(query);
+    m_tableModel= tableModelCreate(tableName,query);
+
+    //加入缓存 先读取全部行 关闭数据库后TableModel仍可用
+    if(!cacheKey.isEmpty()){
+        while(m_tableModel->canFetchMore()){
+            m_tableModel->fetchMore();
+        }
+        ResultCacheEntry entry;
+        entry.versionList = versionList;
+        entry.model = m_tableModel;
+        //按实际数据估算 文本按UTF-16计 二进制按字节数计
+        entry.cost = 0;
+        for (int row = 0; row < m_tableModel->rowCount(); ++row) {
+            QSqlRecord record = m_tableModel->record(row);
+            for (int column = 0; column < record.count(); ++column) {
+                QVariant value = record.value(column);
+                entry.cost += sizeof(QVariant);
+                if(value.typeId()==QMetaType::QString){
+                    entry.cost += value.toString().size()*2;
+                }else if(value.typeId()==QMetaType::QByteArray){
+                    entry.cost += value.toByteArray().size();
+                }
+            }
+        }
+        resultCacheInsert(cacheKey,entry);
+    }
 
     //查询成功 关闭数据库
     databaseClose();
@@ -941,6 +1459,35 @@ bool EasySQLite::recordSelect(const QString &tableName, const QStringList &field
 
 bool EasySQLite::fieldUpdateValue(const QString &tableName, const QString &fieldName, const QVariant &fieldValue,
                              const QString &condiFieldName, const QVariant &condiFieldValue){
+    TraceScope trace(this,TraceMethod::FieldUpdateValue,tableName,fieldName,fieldValue,condiFieldName,condiFieldValue);
+
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("字段更新数值")){
+        return false;
+    }
+
+    //分区表只追加 按分区整体删除
+    if(m_partitionHash.contains(tableName)){
+        m_errorInfo = "[EasySQLite/Error]字段更新数值报错: 分区表只允许追加 请用partitionDrop按分区删除";
+        return false;
+    }
+
+    //分片表 条件字段为主键时路由到单个分片 否则扇出
+    if(m_shardNumHash.contains(tableName)){
+        bool isExist = false;
+        isFieldNameMatch(tableName,condiFieldName,isExist);
+        if(!isExist){
+            m_errorInfo = "[EasySQLite/Error]字段更新数值报错: 条件字段名不存在";
+            return false;
+        }
+        QVariant primarykeyValue;
+        if(condiFieldName==m_shardPrimarykeyHash.value(tableName)){
+            primarykeyValue = condiFieldValue;
+        }
+        return shardFieldUpdate(tableName,fieldName,fieldValue,
+                                condiFieldName+" = "+value2SqlFormat(condiFieldValue),primarykeyValue);
+    }
+
     //检查数据库是否打开
     if(!m_database.isOpen()){
         //未打开 执行打开数据库
@@ -1000,18 +1547,18 @@ bool EasySQLite::fieldUpdateValue(const QString &tableName, const QString &field
     }
 
     //把更新字段值和条件字段值转为SQL格式
-    QString strFieldValue=  value2SqlFormat(fieldValue);
+    QString strFieldValue=  compressedValue2SqlFormat(tableName,fieldName,fieldValue);
     QString strCondiFieldValue=  value2SqlFormat(condiFieldValue);
 
     //开始更新
     QSqlQuery query;
-    if(!query.exec(QString("UPDATE %1 SET %2 = %3 WHERE %4 = %5").arg(tableName).arg(fieldName).arg(strFieldValue).arg(condiFieldName).arg(strCondiFieldValue))){
-        m_errorInfo = "[EasySQLite/Error]字段更新数值报错: 执行SQL语句更新数据失败";
+    if(!queryExec(query,QString("UPDATE %1 SET %2 = %3 WHERE %4 = %5").arg(tableName).arg(fieldName).arg(strFieldValue).arg(condiFieldName).arg(strCondiFieldValue))){
+        m_errorInfo = "[EasySQLite/Error]字段更新数值报错: 执行SQL语句更新数据失败" + query.lastError().text();
         return false;
     }
 
     //select * from tableName 赋值变量model
-    if(!recordSelectTableAll(tableName)){
+    if(!tableModelRefresh(tableName)){
         //查询失败
         m_errorInfo = "[EasySQLite/Error]字段更新数值报错: 查询TableModel错误";
         return false;
@@ -1023,6 +1570,24 @@ bool EasySQLite::fieldUpdateValue(const QString &tableName, const QString &field
 }
 
 bool EasySQLite::fieldUpdate(const QString &tableName, const QString &fieldName, const QVariant &fieldValue, const QString &condition){
+    TraceScope trace(this,TraceMethod::FieldUpdate,tableName,fieldName,fieldValue,condition);
+
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("字段更新")){
+        return false;
+    }
+
+    //分区表只追加 按分区整体删除
+    if(m_partitionHash.contains(tableName)){
+        m_errorInfo = "[EasySQLite/Error]字段更新报错: 分区表只允许追加 请用partitionDrop按分区删除";
+        return false;
+    }
+
+    //分片表 扇出到所有分片
+    if(m_shardNumHash.contains(tableName)){
+        return shardFieldUpdate(tableName,fieldName,fieldValue,condition,QVariant());
+    }
+
     //检查数据库是否打开
     if(!m_database.isOpen()){
         //未打开 执行打开数据库
@@ -1054,20 +1619,20 @@ bool EasySQLite::fieldUpdate(const QString &tableName, const QString &fieldName,
     }
 
     //把更新字段值转为SQL格式
-    QString strFieldValue = value2SqlFormat(fieldValue);
+    QString strFieldValue = compressedValue2SqlFormat(tableName,fieldName,fieldValue);
 
     //制作条件字符串
     QString strCondition = "WHERE "+condition;
 
     //开始更新
     QSqlQuery query;
-    if(!query.exec(QString("UPDATE %1 SET %2 = %3 %4").arg(tableName).arg(fieldName).arg(strFieldValue).arg(strCondition))){
-        m_errorInfo = "[EasySQLite/Error]字段更新报错: 更新字段名不存在";
+    if(!queryExec(query,QString("UPDATE %1 SET %2 = %3 %4").arg(tableName).arg(fieldName).arg(strFieldValue).arg(strCondition))){
+        m_errorInfo = "[EasySQLite/Error]字段更新报错: 执行SQL语句更新数据失败" + query.lastError().text();
         return false;
     }
 
     //select * from tableName 赋值变量model
-    if(!recordSelectTableAll(tableName)){
+    if(!tableModelRefresh(tableName)){
         //查询失败
         m_errorInfo = "[EasySQLite/Error]字段更新报错: 查询TableModel错误";
         return false;
@@ -1078,102 +1643,263 @@ bool EasySQLite::fieldUpdate(const QString &tableName, const QString &fieldName,
     return true;
 }
 
-
-
-
-
-
-
-
-/*
- *  @brief  获取报错字符串成员变量
- *  @param  无
- *  @retval 报错字符串成员变量
- */
-QString EasySQLite::errorInfo(){
-    return m_errorInfo;
-}
-
 /*
- *  @brief  获取表格模型
- *  @param  无
- *  @retval 表格模型
+ *  @brief  聚合查询 COUNT/SUM/AVG/MIN/MAX 与 GROUP BY 全部下推到SQLite执行
+ *  @param  表格名
+ *  @param  聚合列表 例: {{Aggregate::Count,"*"}, {Aggregate::Sum,"price"}}
+ *  @param  分组字段名列表 可为空
+ *  @param  条件字符串 可为空 例: singleConditionCreate()的返回值
+ *  @param  结果(输出) 每行依次为分组字段值和各聚合值
+ *  @retval 是否查询成功
  */
-QSqlTableModel *EasySQLite::tableModel(){
-    if(m_tableModel==nullptr){
-        m_tableModel = new QSqlTableModel(this,m_database);
+bool EasySQLite::recordAggregate(const QString &tableName, const QList<QPair<Aggregate,QString>> &aggregateList,
+                                 const QStringList &groupFieldNameList, const QString &condition,
+                                 QList<QVariantList> &resultList){
+    TraceScope trace(this,TraceMethod::RecordAggregate,tableName,aggregateList,groupFieldNameList,condition);
+
+    //分片表 各分片的AVG无法直接合并 暂不支持
+    if(m_shardNumHash.contains(tableName)){
+        m_errorInfo = "[EasySQLite/Error]聚合查询报错: 分片表不支持聚合查询";
+        return false;
     }
-    return m_tableModel;
-}
 
-QVariant EasySQLite::value(const QString &tableName, const QVariant &primarykeyValue, const QString &fieldName){
     //检查数据库是否打开
     if(!m_database.isOpen()){
         //未打开 执行打开数据库
         if(!databaseOpen()){
             //打开失败
-            m_errorInfo = "[EasySQLite/Error]获取数值报错: 数据库打开失败";
+            m_errorInfo = "[EasySQLite/Error]聚合查询报错: 数据库打开失败";
             return false;
         }
     }
 
     //数据库已打开 判断表格是否存在
     if (!m_database.tables().contains(tableName)) {
-        m_errorInfo = "[EasySQLite/Error]获取数值报错: 表格不存在";
+        m_errorInfo = "[EasySQLite/Error]聚合查询报错: 表格不存在";
         return false;
     }
 
-    //表格存在 判断主键值是否存在
-    //获取主键名
-    QString primaryName = primarykeyName(tableName);
-    //查询主键值是否存在
-    bool isExist;
-    if(!isFieldValueMatch(tableName,primaryName,primarykeyValue,isExist)){
-        //查询失败
-        m_errorInfo = "[EasySQLite/Error]获取数值报错: 查询主键值是否存在错误";
-        return false;
-    }
-    //查询成功
-    if(!isExist){
-        //不存在
-        m_errorInfo = "[EasySQLite/Error]获取数值报错: 主键值不存在";
+    //判断聚合列表是否为空
+    if(aggregateList.isEmpty()){
+        m_errorInfo = "[EasySQLite/Error]聚合查询报错: 聚合列表为空";
         return false;
     }
-    isExist = false;
 
-    //判断字段名是否存在
-    if(!isFieldNameMatch(tableName,fieldName,isExist)){
-        //查询失败
-        m_errorInfo = "[EasySQLite/Error]获取数值报错: 查询字段名是否存在错误";
-        return false;
-    }
-    //查询成功
-    if(!isExist){
-        //不存在
-        m_errorInfo = "[EasySQLite/Error]获取数值报错: 字段名不存在";
+    //一次性获取全部字段名 用于校验
+    QStringList tableFieldNameList;
+    if(!fieldNameQuery(tableName,tableFieldNameList)){
+        m_errorInfo = "[EasySQLite/Error]聚合查询报错: 查询字段名列表错误";
         return false;
     }
 
-    //转换主键值为sql格式
+    //校验分组字段名
+    for (int var = 0; var < groupFieldNameList.size(); ++var) {
+        if(!tableFieldNameList.contains(groupFieldNameList.at(var))){
+            m_errorInfo = "[EasySQLite/Error]聚合查询报错: 分组字段名不存在";
+            return false;
+        }
+    }
+
+    //校验聚合字段名并拼接聚合表达式
+    QStringList columnList = groupFieldNameList;
+    for (int var = 0; var < aggregateList.size(); ++var) {
+        Aggregate aggregate = aggregateList.at(var).first;
+        QString fieldName = aggregateList.at(var).second;
+
+        //只有COUNT允许使用*
+        if(!(aggregate==Aggregate::Count&&fieldName=="*")&&!tableFieldNameList.contains(fieldName)){
+            m_errorInfo = "[EasySQLite/Error]聚合查询报错: 聚合字段名不存在";
+            return false;
+        }
+
+        switch (aggregate) {
+        case Aggregate::Count:
+            columnList.append(QString("COUNT(%1)").arg(fieldName));
+            break;
+        case Aggregate::Sum:
+            columnList.append(QString("SUM(%1)").arg(fieldName));
+            break;
+        case Aggregate::Avg:
+            columnList.append(QString("AVG(%1)").arg(fieldName));
+            break;
+        case Aggregate::Min:
+            columnList.append(QString("MIN(%1)").arg(fieldName));
+            break;
+        case Aggregate::Max:
+            columnList.append(QString("MAX(%1)").arg(fieldName));
+            break;
+        }
+    }
+
+    //制作条件与分组字符串
+    QString strCondition;
+    if(!condition.isEmpty()){
+        strCondition = "WHERE "+condition;
+    }
+    QString strGroup;
+    if(!groupFieldNameList.isEmpty()){
+        strGroup = "GROUP BY "+groupFieldNameList.join(",");
+    }
+
+    //执行查询
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    if(!queryExec(query,QString("SELECT %1 FROM %2 %3 %4").arg(columnList.join(",")).arg(tableName).arg(strCondition).arg(strGroup))){
+        m_errorInfo = "[EasySQLite/Error]聚合查询报错: 执行SQL语句查询错误" + query.lastError().text();
+        return false;
+    }
+
+    //查询成功 读取结果
+    resultList.clear();
+    int columnNum = columnList.size();
+    while(query.next()){
+        QVariantList row;
+        row.reserve(columnNum);
+        for (int columnIndex = 0; columnIndex < columnNum; ++columnIndex) {
+            row.append(query.value(columnIndex));
+        }
+        resultList.append(row);
+    }
+
+    //查询成功 关闭数据库
+    databaseClose();
+    return true;
+}
+
+
+
+
+
+
+
+
+/*
+ *  @brief  获取报错字符串成员变量
+ *  @param  无
+ *  @retval 报错字符串成员变量
+ */
+QString EasySQLite::errorInfo(){
+    return m_errorInfo;
+}
+
+/*
+ *  @brief  获取表格模型
+ *  @param  无
+ *  @retval 表格模型 归EasySQLite所有 随其析构释放
+ *  @note   启用查询结果缓存时 交出的TableModel可能被调用方修改 随即移出缓存 之后的相同查询重新执行
+ */
+QSqlTableModel *EasySQLite::tableModel(){
+    if(m_tableModel==nullptr){
+        m_tableModel = new QSqlTableModel(this,m_database);
+    }
+    QStringList handedOutKeyList;
+    for (auto iterator = m_resultCacheHash.cbegin(); iterator != m_resultCacheHash.cend(); ++iterator) {
+        if(iterator->model==m_tableModel){
+            handedOutKeyList.append(iterator.key());
+        }
+    }
+    for (int var = 0; var < handedOutKeyList.size(); ++var) {
+        resultCacheEvict(handedOutKeyList.at(var));
+    }
+    return m_tableModel;
+}
+
+QVariant EasySQLite::value(const QString &tableName, const QVariant &primarykeyValue, const QString &fieldName){
+    TraceScope trace(this,TraceMethod::Value,tableName,primarykeyValue,fieldName);
+
+    //分片表 路由到主键所在分片
+    if(m_shardNumHash.contains(tableName)){
+        QVariant ret;
+        if(!shardValue(tableName,primarykeyValue,fieldName,ret)){
+            return false;
+        }
+        return ret;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]获取数值报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //数据库已打开 判断表格是否存在
+    if (!m_database.tables().contains(tableName)) {
+        m_errorInfo = "[EasySQLite/Error]获取数值报错: 表格不存在";
+        return false;
+    }
+
+    //表格存在 判断主键值是否存在
+    //获取主键名
+    QString primaryName = primarykeyName(tableName);
+    //查询主键值是否存在
+    bool isExist;
+    if(!isFieldValueMatch(tableName,primaryName,primarykeyValue,isExist)){
+        //查询失败
+        m_errorInfo = "[EasySQLite/Error]获取数值报错: 查询主键值是否存在错误";
+        return false;
+    }
+    //查询成功
+    if(!isExist){
+        //不存在
+        m_errorInfo = "[EasySQLite/Error]获取数值报错: 主键值不存在";
+        return false;
+    }
+    isExist = false;
+
+    //判断字段名是否存在
+    if(!isFieldNameMatch(tableName,fieldName,isExist)){
+        //查询失败
+        m_errorInfo = "[EasySQLite/Error]获取数值报错: 查询字段名是否存在错误";
+        return false;
+    }
+    //查询成功
+    if(!isExist){
+        //不存在
+        m_errorInfo = "[EasySQLite/Error]获取数值报错: 字段名不存在";
+        return false;
+    }
+
+    //转换主键值为sql格式
     QString primaryValue= value2SqlFormat(primarykeyValue);
 
     //开始查询数值
     QSqlQuery query;
-    if(!query.exec(QString("SELECT %1 FROM %2 WHERE %3 = %4").arg(fieldName).arg(tableName).arg(primaryName).arg(primaryValue))){
+    if(!queryExec(query,QString("SELECT %1 FROM %2 WHERE %3 = %4").arg(fieldName).arg(tableName).arg(primaryName).arg(primaryValue))){
         //查询失败
-        m_errorInfo = "[EasySQLite/Error]获取数值报错: 执行SQL语句查询数值错误";
+        m_errorInfo = "[EasySQLite/Error]获取数值报错: 执行SQL语句查询数值错误" + query.lastError().text();
         return false;
     }
 
     //查询成功 获取数据
     query.next();
 
+    //压缩字段解压后返回
+    QVariant ret = query.value(0);
+    if(!decompressValue(tableName,fieldName,ret)){
+        return false;
+    }
+
     //关闭数据库
     databaseClose();
-    return query.value(0);
+    return ret;
 }
 
 bool EasySQLite::isValueExist(const QString &tableName, const QVariant &primarykeyValue, const QString &fieldName, const QVariant &inputValue){
+    TraceScope trace(this,TraceMethod::IsValueExist,tableName,primarykeyValue,fieldName,inputValue);
+
+    //分片表 路由到主键所在分片
+    if(m_shardNumHash.contains(tableName)){
+        QVariant ret;
+        if(!shardValue(tableName,primarykeyValue,fieldName,ret)){
+            return false;
+        }
+        return ret==inputValue;
+    }
+
     //检查数据库是否打开
     if(!m_database.isOpen()){
         //未打开 执行打开数据库
@@ -1226,15 +1952,16 @@ bool EasySQLite::isValueExist(const QString &tableName, const QVariant &primaryk
 
     //开始查询数值
     QSqlQuery query;
-    if(!query.exec(QString("SELECT %1 FROM %2 WHERE %3 = %4").arg(fieldName).arg(tableName).arg(primaryName).arg(primaryValue))){
+    if(!queryExec(query,QString("SELECT %1 FROM %2 WHERE %3 = %4").arg(fieldName).arg(tableName).arg(primaryName).arg(primaryValue))){
         //查询失败
-        m_errorInfo = "[EasySQLite/Error]判断数值是否存在报错: 执行SQL语句查询数值错误";
+        m_errorInfo = "[EasySQLite/Error]判断数值是否存在报错: 执行SQL语句查询数值错误" + query.lastError().text();
         return false;
     }
 
-    //查询成功 获取数据
+    //查询成功 获取数据 压缩字段解压后比较
     query.next();
-    if(query.value(0)!=inputValue){
+    QVariant value = query.value(0);
+    if(!decompressValue(tableName,fieldName,value)||value!=inputValue){
         return false;
     }
 
@@ -1243,3 +1970,4750 @@ bool EasySQLite::isValueExist(const QString &tableName, const QVariant &primaryk
     return true;
 }
 
+/*
+ *  @brief  从QSqlDriver中取出底层sqlite3句柄
+ *  @param  数据库连接
+ *  @retval sqlite3句柄 非QSQLITE驱动或未打开时返回nullptr
+ */
+sqlite3* EasySQLite::sqliteHandle(const QSqlDatabase &database){
+    if(!database.isValid()||!database.isOpen()){
+        return nullptr;
+    }
+    QVariant handle = database.driver()->handle();
+    if(!handle.isValid()||qstrcmp(handle.typeName(),"sqlite3*")!=0){
+        //不是QSQLITE驱动
+        return nullptr;
+    }
+    return *static_cast<sqlite3* const*>(handle.constData());
+}
+
+/*
+ *  @brief  向当前连接注册update/commit/rollback钩子
+ *  @param  无
+ *  @retval 无
+ *  @note   进程内只要有任意实例开启了变更通知 所有实例打开连接时都会注册钩子
+ *          这样其它连接上的写入也能通知到监听者 钩子随连接关闭而失效 每次打开都需重新注册
+ */
+void EasySQLite::hookInstall(){
+    sqlite3* handle = sqliteHandle(m_database);
+    if(handle==nullptr){
+        return;
+    }
+
+    //判断进程内是否有监听者或查询结果缓存
+    QMutexLocker locker(&s_changeMutex);
+    if(s_changeListenerList.isEmpty()&&s_resultCacheNum==0){
+        //无监听者 卸载钩子
+        sqlite3_update_hook(handle,nullptr,nullptr);
+        sqlite3_commit_hook(handle,nullptr,nullptr);
+        sqlite3_rollback_hook(handle,nullptr,nullptr);
+        s_pendingChangeHash.remove(handle);
+        s_committingChangeHash.remove(handle);
+        return;
+    }
+
+    //有监听者 以句柄本身作为用户数据注册钩子 避免实例析构后悬空
+    sqlite3_update_hook(handle,&EasySQLite::updateHookCallback,handle);
+    sqlite3_commit_hook(handle,&EasySQLite::commitHookCallback,handle);
+    sqlite3_rollback_hook(handle,&EasySQLite::rollbackHookCallback,handle);
+}
+
+/*
+ *  @brief  sqlite3_update_hook回调 记录事务内的行变更
+ *  @param  注册时传入的sqlite3句柄
+ *  @param  操作类型 SQLITE_INSERT/SQLITE_UPDATE/SQLITE_DELETE
+ *  @param  数据库名 例: main
+ *  @param  表格名
+ *  @param  行rowid
+ *  @retval 无
+ *  @note   WITHOUT ROWID表以及不带条件的DELETE(truncate优化)不会触发该回调
+ */
+void EasySQLite::updateHookCallback(void *userData, int operation, const char *databaseName,
+                                    const char *tableName, qint64 rowid){
+    Q_UNUSED(databaseName)
+
+    ESChange change;
+    change.tableName = QString::fromUtf8(tableName);
+    change.rowid = rowid;
+    switch (operation) {
+    case SQLITE_INSERT:
+        change.operation = ESChange::Operation::Insert;
+        break;
+    case SQLITE_DELETE:
+        change.operation = ESChange::Operation::Delete;
+        break;
+    default:
+        change.operation = ESChange::Operation::Update;
+        break;
+    }
+
+    //递增写版本 使依赖该表格的查询结果缓存失效
+    QMutexLocker locker(&s_changeMutex);
+    s_tableVersionHash[change.tableName]++;
+
+    //有监听者时暂存 等待提交
+    if(!s_changeListenerList.isEmpty()){
+        s_pendingChangeHash[static_cast<sqlite3*>(userData)].append(change);
+    }
+}
+
+/*
+ *  @brief  sqlite3_commit_hook回调 把事务内的变更转为提交中 提交是否成功在语句返回后由changeCommitResolve判断
+ *  @param  注册时传入的sqlite3句柄
+ *  @retval 0 允许提交
+ *  @note   该回调在COMMIT真正完成前调用 提交可能随后因SQLITE_BUSY等失败 此时不能投递
+ */
+int EasySQLite::commitHookCallback(void *userData){
+    QMutexLocker locker(&s_changeMutex);
+    QList<ESChange> changeList = s_pendingChangeHash.take(static_cast<sqlite3*>(userData));
+    if(!changeList.isEmpty()){
+        s_committingChangeHash[static_cast<sqlite3*>(userData)].append(changeList);
+    }
+    return 0;
+}
+
+/*
+ *  @brief  sqlite3_rollback_hook回调 丢弃事务内的变更
+ *  @param  注册时传入的sqlite3句柄
+ *  @retval 无
+ */
+void EasySQLite::rollbackHookCallback(void *userData){
+    //回滚撤销的写入已递增过写版本 期间读到的未提交数据可能已被缓存 递增纪元使其全部失效
+    QMutexLocker locker(&s_changeMutex);
+    s_pendingChangeHash.remove(static_cast<sqlite3*>(userData));
+    s_committingChangeHash.remove(static_cast<sqlite3*>(userData));
+    s_writeEpoch++;
+}
+
+/*
+ *  @brief  语句返回后判断提交中的变更是否已真正提交 已提交则投递给所有监听者
+ *  @param  sqlite3句柄
+ *  @retval 无
+ *  @note   回到自动提交状态说明提交完成(回滚时钩子已丢弃变更) 否则提交失败 事务仍在进行 变更放回待提交
+ */
+void EasySQLite::changeCommitResolve(sqlite3 *handle){
+    if(handle==nullptr){
+        return;
+    }
+    QMutexLocker locker(&s_changeMutex);
+    auto iterator = s_committingChangeHash.find(handle);
+    if(iterator==s_committingChangeHash.end()){
+        return;
+    }
+    QList<ESChange> changeList = iterator.value();
+    s_committingChangeHash.erase(iterator);
+    if(sqlite3_get_autocommit(handle)==0){
+        //提交失败 等待调用方重试提交或回滚
+        QList<ESChange>& pendingList = s_pendingChangeHash[handle];
+        changeList.append(pendingList);
+        pendingList = changeList;
+        return;
+    }
+    changeDeliver(changeList);
+}
+
+/*
+ *  @brief  把已提交的变更追加到每个监听者的队列 调用方需持有s_changeMutex
+ *  @param  变更列表
+ *  @retval 无
+ */
+void EasySQLite::changeDeliver(const QList<ESChange> &changeList){
+    //同一轮事件循环内只投递一次刷新 实现合并
+    for (int var = 0; var < s_changeListenerList.size(); ++var) {
+        EasySQLite* listener = s_changeListenerList.at(var);
+        listener->m_changeList.append(changeList);
+        if(!listener->m_isChangeFlushQueued){
+            listener->m_isChangeFlushQueued = true;
+            QMetaObject::invokeMethod(listener,[listener](){listener->changeFlush();},Qt::QueuedConnection);
+        }
+    }
+}
+
+/*
+ *  @brief  合并同一行的多次变更
+ *  @param  按发生顺序排列的变更列表
+ *  @retval 合并后的变更列表 每个(表格名,rowid)只保留一条
+ *  @note   插入后更新仍视为插入 插入后删除直接抵消 其余情况以最后一次操作为准
+ */
+QList<ESChange> EasySQLite::changeListCoalesce(const QList<ESChange> &changeList){
+    QList<ESChange> ret;
+    QHash<QPair<QString,qint64>,int> indexHash;
+    QList<bool> isDroppedList;
+    for (int var = 0; var < changeList.size(); ++var) {
+        const ESChange& change = changeList.at(var);
+        QPair<QString,qint64> key = qMakePair(change.tableName,change.rowid);
+        int index = indexHash.value(key,-1);
+        if(index<0||isDroppedList.at(index)){
+            //首次出现
+            indexHash.insert(key,ret.size());
+            ret.append(change);
+            isDroppedList.append(false);
+            continue;
+        }
+
+        //已出现过 合并
+        ESChange& previous = ret[index];
+        if(previous.operation==ESChange::Operation::Insert){
+            if(change.operation==ESChange::Operation::Delete){
+                isDroppedList[index] = true;
+            }
+        }else{
+            previous.operation = change.operation;
+        }
+    }
+
+    //移除抵消掉的变更
+    QList<ESChange> coalescedList;
+    for (int var = 0; var < ret.size(); ++var) {
+        if(!isDroppedList.at(var)){
+            coalescedList.append(ret.at(var));
+        }
+    }
+    return coalescedList;
+}
+
+/*
+ *  @brief  在监听者所在线程发出合并后的变更信号
+ *  @param  无
+ *  @retval 无
+ */
+void EasySQLite::changeFlush(){
+    QList<ESChange> changeList;
+    {
+        QMutexLocker locker(&s_changeMutex);
+        changeList.swap(m_changeList);
+        m_isChangeFlushQueued = false;
+    }
+
+    changeList = changeListCoalesce(changeList);
+    if(!changeList.isEmpty()){
+        emit recordsChanged(changeList);
+    }
+}
+
+/*
+ *  @brief  开启/关闭数据变更通知
+ *  @param  是否开启
+ *  @retval 无
+ *  @note   开启后任意连接提交的变更都会在事件循环中以recordsChanged信号批量发出
+ */
+void EasySQLite::setChangeNotifyEnabled(bool enabled){
+    {
+        QMutexLocker locker(&s_changeMutex);
+        if(m_changeNotifyEnabled==enabled){
+            return;
+        }
+        m_changeNotifyEnabled = enabled;
+        if(enabled){
+            s_changeListenerList.append(this);
+        }else{
+            s_changeListenerList.removeAll(this);
+            m_changeList.clear();
+        }
+    }
+
+    //连接已打开时立即刷新钩子
+    hookInstall();
+}
+
+/*
+ *  @brief  获取是否开启数据变更通知
+ *  @param  无
+ *  @retval 是否开启
+ */
+bool EasySQLite::isChangeNotifyEnabled(){
+    return m_changeNotifyEnabled;
+}
+
+/*
+ *  @brief  内存模式下从磁盘文件加载数据到内存数据库
+ *  @param  无
+ *  @retval 是否加载成功 磁盘文件不存在时视为空库 返回成功
+ */
+bool EasySQLite::memoryLoad(){
+    sqlite3* memory = sqliteHandle(m_database);
+    if(memory==nullptr){
+        m_errorInfo = "[EasySQLite/Error]内存数据库加载报错: 获取sqlite3句柄失败";
+        return false;
+    }
+
+    //以只读方式打开磁盘文件 不存在则无需加载
+    sqlite3* disk = nullptr;
+    if(sqlite3_open_v2(m_diskPath.toUtf8().constData(),&disk,SQLITE_OPEN_READONLY,nullptr)!=SQLITE_OK){
+        sqlite3_close(disk);
+        return true;
+    }
+
+    //整库一次性拷贝
+    sqlite3_backup* backup = sqlite3_backup_init(memory,"main",disk,"main");
+    if(backup==nullptr){
+        m_errorInfo = "[EasySQLite/Error]内存数据库加载报错: " + QString::fromUtf8(sqlite3_errmsg(memory));
+        sqlite3_close(disk);
+        return false;
+    }
+    sqlite3_backup_step(backup,-1);
+    int ret = sqlite3_backup_finish(backup);
+    sqlite3_close(disk);
+    if(ret!=SQLITE_OK){
+        m_errorInfo = "[EasySQLite/Error]内存数据库加载报错: " + QString::fromUtf8(sqlite3_errstr(ret));
+        return false;
+    }
+    return true;
+}
+
+/*
+ *  @brief  开始一次内存数据库到磁盘文件的在线备份
+ *  @param  无
+ *  @retval 是否成功开始
+ */
+bool EasySQLite::backupBegin(){
+    sqlite3* memory = sqliteHandle(m_database);
+    if(memory==nullptr){
+        m_errorInfo = "[EasySQLite/Error]数据库备份报错: 获取sqlite3句柄失败";
+        return false;
+    }
+
+    //打开磁盘文件 不存在则创建
+    if(sqlite3_open_v2(m_diskPath.toUtf8().constData(),&m_backupDisk,
+                        SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE,nullptr)!=SQLITE_OK){
+        m_errorInfo = "[EasySQLite/Error]数据库备份报错: 磁盘文件打开失败 " + QString::fromUtf8(sqlite3_errmsg(m_backupDisk));
+        sqlite3_close(m_backupDisk);
+        m_backupDisk = nullptr;
+        return false;
+    }
+
+    //初始化备份对象
+    m_backup = sqlite3_backup_init(m_backupDisk,"main",memory,"main");
+    if(m_backup==nullptr){
+        m_errorInfo = "[EasySQLite/Error]数据库备份报错: " + QString::fromUtf8(sqlite3_errmsg(m_backupDisk));
+        sqlite3_close(m_backupDisk);
+        m_backupDisk = nullptr;
+        return false;
+    }
+    m_backupStartTime = QDateTime::currentMSecsSinceEpoch();
+    m_backupBusyNum = 0;
+    return true;
+}
+
+/*
+ *  @brief  执行一步备份
+ *  @param  本步拷贝的页数 -1表示拷贝剩余全部页
+ *  @retval sqlite3_backup_step的返回值
+ */
+int EasySQLite::backupStep(int pageNum){
+    int ret = sqlite3_backup_step(m_backup,pageNum);
+    emit backupProgress(sqlite3_backup_remaining(m_backup),sqlite3_backup_pagecount(m_backup));
+    return ret;
+}
+
+/*
+ *  @brief  结束备份 释放备份对象并报告耗时
+ *  @param  备份过程是否成功
+ *  @retval 无
+ */
+void EasySQLite::backupEnd(bool isSuccess){
+    if(sqlite3_backup_finish(m_backup)!=SQLITE_OK){
+        isSuccess = false;
+    }
+    if(!isSuccess){
+        m_errorInfo = "[EasySQLite/Error]数据库备份报错: " + QString::fromUtf8(sqlite3_errmsg(m_backupDisk));
+    }
+    sqlite3_close(m_backupDisk);
+    m_backup = nullptr;
+    m_backupDisk = nullptr;
+
+    //报告耗时
+    qint64 duration = QDateTime::currentMSecsSinceEpoch()-m_backupStartTime;
+    if(isSuccess){
+        m_lastBackupDuration = duration;
+        qDebug().noquote()<<QString("[EasySQLite/Info]数据库备份完成 耗时%1ms").arg(duration);
+    }
+    emit backupFinished(isSuccess,duration);
+}
+
+/*
+ *  @brief  定时备份的一个时间片 每次只拷贝backupStepPages页 未完成则让出事件循环后继续
+ *          目标文件被占用时按锁竞争策略退避 连续被占用超过重试次数后放弃本次备份
+ *  @param  无
+ *  @retval 无
+ */
+void EasySQLite::backupSlice(){
+    if(m_backup==nullptr){
+        return;
+    }
+
+    int ret = backupStep(m_backupStepPages);
+    if(ret==SQLITE_DONE){
+        backupEnd(true);
+    }else if(ret==SQLITE_OK){
+        //未完成 下一轮事件循环继续
+        m_backupBusyNum = 0;
+        QTimer::singleShot(0,this,[this](){backupSlice();});
+    }else if((ret==SQLITE_BUSY||ret==SQLITE_LOCKED)&&m_backupBusyNum<m_busyRetryNum){
+        //目标文件被占用 延时后重试 退避每次翻倍 不超过backoffMax
+        int backoff = qMin(m_busyBackoff<<qMin(m_backupBusyNum,16),m_busyBackoffMax);
+        m_backupBusyNum++;
+        QTimer::singleShot(backoff,this,[this](){backupSlice();});
+    }else{
+        if(ret==SQLITE_BUSY||ret==SQLITE_LOCKED){
+            m_errorInfo = "[EasySQLite/Error]数据库备份报错: 磁盘文件持续被占用 放弃本次备份";
+        }
+        backupEnd(false);
+    }
+}
+
+/*
+ *  @brief  立即把内存数据库完整备份到磁盘文件
+ *  @param  无
+ *  @retval 是否备份成功 非内存模式直接返回成功
+ */
+bool EasySQLite::databaseBackup(){
+    if(!m_memoryMode){
+        return true;
+    }
+
+    //有未完成的增量备份时接着完成 否则重新开始
+    if(m_backup==nullptr&&!backupBegin()){
+        return false;
+    }
+    int ret = backupStep(-1);
+    backupEnd(ret==SQLITE_DONE);
+    return ret==SQLITE_DONE;
+}
+
+/*
+ *  @brief  获取最近一次成功备份的耗时
+ *  @param  无
+ *  @retval 耗时(毫秒) 尚未备份过返回-1
+ */
+qint64 EasySQLite::lastBackupDuration(){
+    return m_lastBackupDuration;
+}
+
+/*
+ *  @brief  在每个分片文件中创建分片表 并缓存字段名与主键名
+ *  @param  表格名
+ *  @param  创建表格的字段参数
+ *  @param  分片数量
+ *  @retval 是否初始化成功
+ */
+bool EasySQLite::shardTableInit(const QString &tableName, const QString &definition, int shardNum){
+    //分片依据主键哈希 必须指定主键
+    if(shardNum<=0||!definition.contains("PRIMARY KEY", Qt::CaseInsensitive)){
+        m_errorInfo = "[EasySQLite/Error]分片表初始化报错: 未指定主键或分片数量错误";
+        return false;
+    }
+
+    for (int shardIndex = 0; shardIndex < shardNum; ++shardIndex) {
+        QSqlDatabase database = shardDatabase(shardIndex);
+        if(!database.isOpen()){
+            return false;
+        }
+
+        //WAL模式 读写互不阻塞
+        QSqlQuery query(database);
+        if(!query.exec("PRAGMA journal_mode=WAL")){
+            m_errorInfo = "[EasySQLite/Error]分片表初始化报错: 设置WAL模式错误" + query.lastError().text();
+            return false;
+        }
+
+        //不存在则建表
+        if(!database.tables().contains(tableName)
+            &&!query.exec(QString("CREATE TABLE %1(%2)").arg(tableName).arg(definition))){
+            m_errorInfo = "[EasySQLite/Error]分片表初始化报错: 执行SQL语句建表错误" + query.lastError().text();
+            return false;
+        }
+    }
+
+    //从第一个分片读取字段名与主键名
+    QSqlQuery query(shardDatabase(0));
+    if(!query.exec(QString("PRAGMA TABLE_INFO(%1)").arg(tableName))){
+        m_errorInfo = "[EasySQLite/Error]分片表初始化报错: 执行SQL语句查询表格信息错误" + query.lastError().text();
+        return false;
+    }
+    QStringList fieldNameList;
+    QString primaryName;
+    while(query.next()){
+        fieldNameList.append(query.value(1).toString());
+        if(query.value(5).toInt()){
+            primaryName = query.value(1).toString();
+        }
+    }
+
+    m_shardNumHash.insert(tableName,shardNum);
+    m_shardFieldNameHash.insert(tableName,fieldNameList);
+    m_shardPrimarykeyHash.insert(tableName,primaryName);
+    return true;
+}
+
+/*
+ *  @brief  分片常驻连接名 按对象与分片序号命名 不同EasySQLite对象的分片连接互不共用
+ *  @param  分片序号
+ *  @retval 连接名
+ */
+QString EasySQLite::shardConnectionName(int shardIndex){
+    return QString("easysqlite_shard_%1_%2").arg(reinterpret_cast<quintptr>(this),0,16).arg(shardIndex);
+}
+
+/*
+ *  @brief  获取分片常驻连接 不存在则创建并打开
+ *          连接属于本对象 析构时移除 只能在创建它的线程中使用
+ *  @param  分片序号
+ *  @retval 分片连接 打开失败时isOpen()为false
+ */
+QSqlDatabase EasySQLite::shardDatabase(int shardIndex){
+    QString connectionName = shardConnectionName(shardIndex);
+    if(!QSqlDatabase::contains(connectionName)){
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE",connectionName);
+        database.setDatabaseName(m_shardPathList.at(shardIndex));
+    }
+
+    QSqlDatabase database = QSqlDatabase::database(connectionName,false);
+    if(!database.isOpen()){
+        if(!database.open()){
+            m_errorInfo = "[EasySQLite/Error]分片连接打开报错: " + database.lastError().text();
+            return database;
+        }
+        sqlite3_busy_timeout(sqliteHandle(database),m_busyTimeout);
+    }
+    return database;
+}
+
+/*
+ *  @brief  计算主键值所在的分片
+ *  @param  主键值
+ *  @param  分片数量
+ *  @retval 分片序号
+ *  @note   使用FNV-1a而不是qHash 保证跨进程/跨Qt版本结果稳定
+ */
+int EasySQLite::shardIndex(const QVariant &primarykeyValue, int shardNum){
+    QByteArray key = primarykeyValue.toString().toUtf8();
+    quint32 hash = 2166136261u;
+    for (int var = 0; var < key.size(); ++var) {
+        hash ^= static_cast<quint8>(key.at(var));
+        hash *= 16777619u;
+    }
+    return static_cast<int>(hash%static_cast<quint32>(shardNum));
+}
+
+/*
+ *  @brief  按SQLite的排序规则比较两个值 NULL < 数字 < 文本
+ *  @param  左值
+ *  @param  右值
+ *  @retval 左值是否小于右值
+ */
+bool EasySQLite::shardValueLess(const QVariant &left, const QVariant &right){
+    if(left.isNull()||right.isNull()){
+        return left.isNull()&&!right.isNull();
+    }
+
+    bool isLeftNumber = false;
+    bool isRightNumber = false;
+    double leftNumber = left.toDouble(&isLeftNumber);
+    double rightNumber = right.toDouble(&isRightNumber);
+    if(left.typeId()==QMetaType::QString){
+        isLeftNumber = false;
+    }
+    if(right.typeId()==QMetaType::QString){
+        isRightNumber = false;
+    }
+
+    if(isLeftNumber&&isRightNumber){
+        return leftNumber<rightNumber;
+    }
+    if(isLeftNumber!=isRightNumber){
+        return isLeftNumber;
+    }
+    return left.toString()<right.toString();
+}
+
+/*
+ *  @brief  在指定连接上执行分片任务 写任务在同一事务内执行
+ *          读语句与BEGIN/COMMIT遇到SQLITE_BUSY/LOCKED时按锁竞争策略退避重试 事务中的语句不重试
+ *  @param  分片连接
+ *  @param  分片任务
+ *  @retval 无 结果写回任务
+ */
+void EasySQLite::shardSqlExec(QSqlDatabase &database, ShardTask &task){
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+
+    //与busyRetryExec相同的抖动指数退避 在工作线程中执行 不计入锁等待统计
+    auto retryExec = [this,&query](const QString& sql){
+        bool ret = query.exec(sql);
+        int backoff = m_busyBackoff;
+        for (int retryIndex = 0; retryIndex < m_busyRetryNum&&!ret; ++retryIndex) {
+            int code = query.lastError().nativeErrorCode().toInt()&0xff;
+            if(code!=SQLITE_BUSY&&code!=SQLITE_LOCKED){
+                break;
+            }
+            QThread::msleep(static_cast<unsigned long>(backoff/2+QRandomGenerator::global()->bounded(backoff/2+1)));
+            backoff = qMin(backoff*2,m_busyBackoffMax);
+            ret = query.exec(sql);
+        }
+        return ret;
+    };
+
+    //读任务 只执行第一条语句并取回全部行
+    if(task.isSelect){
+        if(!retryExec(task.sqlList.first())){
+            task.errorInfo = query.lastError().text();
+            return;
+        }
+        int fieldNum = query.record().count();
+        while(query.next()){
+            QVariantList row;
+            row.reserve(fieldNum);
+            for (int fieldIndex = 0; fieldIndex < fieldNum; ++fieldIndex) {
+                row.append(query.value(fieldIndex));
+            }
+            task.rowList.append(row);
+        }
+        task.isSuccess = true;
+        return;
+    }
+
+    //写任务 整组语句一个事务 立即取得写锁
+    if(!retryExec("BEGIN IMMEDIATE")){
+        task.errorInfo = query.lastError().text();
+        return;
+    }
+    for (int var = 0; var < task.sqlList.size(); ++var) {
+        if(!query.exec(task.sqlList.at(var))){
+            task.errorInfo = query.lastError().text();
+            query.exec("ROLLBACK");
+            return;
+        }
+        task.affectedNum += query.numRowsAffected();
+    }
+    if(!retryExec("COMMIT")){
+        task.errorInfo = query.lastError().text();
+        query.exec("ROLLBACK");
+        return;
+    }
+    task.isSuccess = true;
+}
+
+/*
+ *  @brief  在工作线程中为分片任务创建独立连接并执行
+ *  @param  分片文件路径
+ *  @param  分片任务
+ *  @retval 无 结果写回任务
+ */
+void EasySQLite::shardTaskRun(const QString &path, ShardTask *task){
+    static QAtomicInt s_taskIndex;
+    QString connectionName = QString("easysqlite_shard_task_%1").arg(s_taskIndex.fetchAndAddRelaxed(1));
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE",connectionName);
+        database.setDatabaseName(path);
+        if(database.open()){
+            sqlite3_busy_timeout(sqliteHandle(database),m_busyTimeout);
+            shardSqlExec(database,*task);
+            database.close();
+        }else{
+            task->errorInfo = database.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+/*
+ *  @brief  执行一组分片任务 单个任务直接使用常驻连接 多个任务在线程池中并行
+ *  @param  分片任务列表
+ *  @retval 是否全部执行成功
+ */
+bool EasySQLite::shardTaskListRun(QList<ShardTask> &taskList){
+    m_lastActivityTime = QDateTime::currentMSecsSinceEpoch();
+
+    if(taskList.size()==1){
+        QSqlDatabase database = shardDatabase(taskList.first().shardIndex);
+        if(!database.isOpen()){
+            return false;
+        }
+        shardSqlExec(database,taskList[0]);
+    }else{
+        //每个分片各用一个连接 并行执行
+        QList<QFuture<void>> futureList;
+        for (int var = 0; var < taskList.size(); ++var) {
+            ShardTask* task = &taskList[var];
+            QString path = m_shardPathList.at(task->shardIndex);
+            futureList.append(QtConcurrent::run([this,path,task](){shardTaskRun(path,task);}));
+        }
+        for (int var = 0; var < futureList.size(); ++var) {
+            futureList[var].waitForFinished();
+        }
+    }
+
+    //汇总错误
+    for (int var = 0; var < taskList.size(); ++var) {
+        if(!taskList.at(var).isSuccess){
+            m_errorInfo = QString("[EasySQLite/Error]分片执行报错: 分片%1 %2").arg(taskList.at(var).shardIndex).arg(taskList.at(var).errorInfo);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ *  @brief  对各分片已排序的结果做多路归并
+ *  @param  分片读任务列表
+ *  @param  排序字段在结果行中的下标
+ *  @param  排序策略
+ *  @retval 无 结果写入m_shardRecordList
+ */
+void EasySQLite::shardRecordMerge(const QList<ShardTask> &taskList, int sortIndex, const SortPolicy &sortPolicy){
+    m_shardRecordList.clear();
+    QList<int> cursorList(taskList.size(),0);
+    while(true){
+        //在各分片当前行中选出最先的一行
+        int selectedTask = -1;
+        for (int taskIndex = 0; taskIndex < taskList.size(); ++taskIndex) {
+            const QList<QVariantList>& rowList = taskList.at(taskIndex).rowList;
+            if(cursorList.at(taskIndex)>=rowList.size()){
+                continue;
+            }
+            if(selectedTask<0){
+                selectedTask = taskIndex;
+                continue;
+            }
+            const QVariant& current = rowList.at(cursorList.at(taskIndex)).at(sortIndex);
+            const QVariant& selected = taskList.at(selectedTask).rowList.at(cursorList.at(selectedTask)).at(sortIndex);
+            bool isBefore = (sortPolicy==SortPolicy::ASC)?shardValueLess(current,selected):shardValueLess(selected,current);
+            if(isBefore){
+                selectedTask = taskIndex;
+            }
+        }
+
+        //全部分片归并完成
+        if(selectedTask<0){
+            break;
+        }
+        m_shardRecordList.append(taskList.at(selectedTask).rowList.at(cursorList.at(selectedTask)));
+        cursorList[selectedTask]++;
+    }
+}
+
+/*
+ *  @brief  分片表插入 按主键分组后各分片并行写入
+ *  @param  表格名
+ *  @param  插入数据参数列表
+ *  @retval 是否插入成功 多个分片中部分失败时 已成功分片的插入不回滚
+ */
+bool EasySQLite::shardRecordInsert(const QString &tableName, const QList<QVariantList> &valuesList){
+    //分片表的读路径不解压 不能写入压缩数据
+    if(m_compressHash.contains(tableName)){
+        m_errorInfo = "[EasySQLite/Error]分片表插入报错: 分片表不支持压缩字段";
+        return false;
+    }
+    int shardNum = m_shardNumHash.value(tableName);
+    int primaryIndex = m_shardFieldNameHash.value(tableName).indexOf(m_shardPrimarykeyHash.value(tableName));
+
+    //按主键哈希分组
+    QHash<int,QStringList> shardSqlHash;
+    for (int var = 0; var < valuesList.size(); ++var) {
+        const QVariantList& values = valuesList.at(var);
+        if(primaryIndex<0||primaryIndex>=values.size()||values.at(primaryIndex).isNull()){
+            m_errorInfo = "[EasySQLite/Error]分片表插入报错: 未指定主键值";
+            return false;
+        }
+        shardSqlHash[shardIndex(values.at(primaryIndex),shardNum)].append(
+            QString("INSERT INTO %1 VALUES(%2)").arg(tableName).arg(values2SqlFormat(values)));
+    }
+
+    //各分片并行执行
+    QList<ShardTask> taskList;
+    for (auto it = shardSqlHash.constBegin(); it != shardSqlHash.constEnd(); ++it) {
+        ShardTask task;
+        task.shardIndex = it.key();
+        task.sqlList = it.value();
+        taskList.append(task);
+    }
+    return shardTaskListRun(taskList);
+}
+
+/*
+ *  @brief  分片表删除 所有主键值存在时才按分片分组并行删除 重复的主键值只计一次
+ *  @param  表格名
+ *  @param  主键值列表
+ *  @retval 是否删除成功 多个分片中部分失败时 已成功分片的删除不回滚
+ */
+bool EasySQLite::shardRecordDelete(const QString &tableName, const QVariantList &primarykeyValueList){
+    int shardNum = m_shardNumHash.value(tableName);
+    QString primaryName = m_shardPrimarykeyHash.value(tableName);
+
+    //按主键哈希分组 去掉重复主键值 否则与COUNT(*)比较时误判为不存在
+    QHash<int,QStringList> shardValueHash;
+    QSet<QString> valueSet;
+    for (int var = 0; var < primarykeyValueList.size(); ++var) {
+        QString value = value2SqlFormat(primarykeyValueList.at(var));
+        if(!valueSet.contains(value)){
+            valueSet.insert(value);
+            shardValueHash[shardIndex(primarykeyValueList.at(var),shardNum)].append(value);
+        }
+    }
+
+    //判断主键值是否全部存在
+    QList<ShardTask> taskList;
+    for (auto it = shardValueHash.constBegin(); it != shardValueHash.constEnd(); ++it) {
+        ShardTask task;
+        task.shardIndex = it.key();
+        task.isSelect = true;
+        task.sqlList.append(QString("SELECT COUNT(*) FROM %1 WHERE %2 IN (%3)").arg(tableName).arg(primaryName).arg(it.value().join(",")));
+        taskList.append(task);
+    }
+    if(!shardTaskListRun(taskList)){
+        return false;
+    }
+    for (int var = 0; var < taskList.size(); ++var) {
+        if(taskList.at(var).rowList.first().first().toInt()!=shardValueHash.value(taskList.at(var).shardIndex).size()){
+            m_errorInfo = "[EasySQLite/Error]分片表删除报错: 主键值不存在";
+            return false;
+        }
+    }
+
+    //开始删除
+    for (int var = 0; var < taskList.size(); ++var) {
+        ShardTask& task = taskList[var];
+        task.isSelect = false;
+        task.isSuccess = false;
+        task.rowList.clear();
+        task.sqlList = QStringList{QString("DELETE FROM %1 WHERE %2 IN (%3)").arg(tableName).arg(primaryName)
+                                        .arg(shardValueHash.value(task.shardIndex).join(","))};
+    }
+    return shardTaskListRun(taskList);
+}
+
+/*
+ *  @brief  分片表查询 扇出到所有分片并按排序字段归并
+ *  @param  表格名
+ *  @param  查询字段名列表
+ *  @param  条件字符串 可为空
+ *  @param  排序字段名
+ *  @param  排序策略
+ *  @retval 是否查询成功 结果通过shardRecords()获取
+ */
+bool EasySQLite::shardRecordSelect(const QString &tableName, const QStringList &fieldNameList, const QString &condition,
+                                   const QString &sortFieldName, const SortPolicy &sortPolicy){
+    //校验字段名
+    const QStringList& tableFieldNameList = m_shardFieldNameHash[tableName];
+    for (int var = 0; var < fieldNameList.size(); ++var) {
+        if(!tableFieldNameList.contains(fieldNameList.at(var))){
+            m_errorInfo = "[EasySQLite/Error]分片表查询报错: 查询字段名不存在";
+            return false;
+        }
+    }
+    if(!tableFieldNameList.contains(sortFieldName)){
+        m_errorInfo = "[EasySQLite/Error]分片表查询报错: 排序字段名不存在";
+        return false;
+    }
+
+    //归并需要排序字段 未被查询时临时追加到末尾
+    QStringList selectFieldNameList = fieldNameList;
+    int sortIndex = selectFieldNameList.indexOf(sortFieldName);
+    if(sortIndex<0){
+        sortIndex = selectFieldNameList.size();
+        selectFieldNameList.append(sortFieldName);
+    }
+
+    //制作查询语句
+    QString strCondition;
+    if(!condition.isEmpty()){
+        strCondition = "WHERE "+condition;
+    }
+    QString policy = (sortPolicy==SortPolicy::ASC)?"ASC":"DESC";
+    QString sql = QString("SELECT %1 FROM %2 %3 ORDER BY %4 %5").arg(selectFieldNameList.join(",")).arg(tableName)
+                      .arg(strCondition).arg(sortFieldName).arg(policy);
+
+    //扇出到所有分片
+    QList<ShardTask> taskList;
+    for (int shardIndex = 0; shardIndex < m_shardNumHash.value(tableName); ++shardIndex) {
+        ShardTask task;
+        task.shardIndex = shardIndex;
+        task.isSelect = true;
+        task.sqlList.append(sql);
+        taskList.append(task);
+    }
+    if(!shardTaskListRun(taskList)){
+        return false;
+    }
+
+    //归并 去掉临时追加的排序字段
+    shardRecordMerge(taskList,sortIndex,sortPolicy);
+    if(selectFieldNameList.size()!=fieldNameList.size()){
+        for (int var = 0; var < m_shardRecordList.size(); ++var) {
+            m_shardRecordList[var].removeLast();
+        }
+    }
+    m_shardRecordFieldNameList = fieldNameList;
+    return true;
+}
+
+/*
+ *  @brief  分片表字段更新 指定主键值时只更新其所在分片 否则扇出
+ *  @param  表格名
+ *  @param  更新字段名
+ *  @param  更新字段值
+ *  @param  条件字符串
+ *  @param  主键值 无效值表示扇出
+ *  @retval 是否更新成功
+ */
+bool EasySQLite::shardFieldUpdate(const QString &tableName, const QString &fieldName, const QVariant &fieldValue,
+                                  const QString &condition, const QVariant &primarykeyValue){
+    if(!m_shardFieldNameHash.value(tableName).contains(fieldName)){
+        m_errorInfo = "[EasySQLite/Error]分片表字段更新报错: 更新字段名不存在";
+        return false;
+    }
+    if(isCompressedField(tableName,fieldName)){
+        m_errorInfo = "[EasySQLite/Error]分片表字段更新报错: 分片表不支持压缩字段";
+        return false;
+    }
+
+    //制作更新语句
+    QString strCondition;
+    if(!condition.isEmpty()){
+        strCondition = "WHERE "+condition;
+    }
+    QString sql = QString("UPDATE %1 SET %2 = %3 %4").arg(tableName).arg(fieldName).arg(value2SqlFormat(fieldValue)).arg(strCondition);
+
+    //路由或扇出
+    QList<ShardTask> taskList;
+    int shardNum = m_shardNumHash.value(tableName);
+    for (int index = 0; index < shardNum; ++index) {
+        if(primarykeyValue.isValid()&&index!=shardIndex(primarykeyValue,shardNum)){
+            continue;
+        }
+        ShardTask task;
+        task.shardIndex = index;
+        task.sqlList.append(sql);
+        taskList.append(task);
+    }
+    if(!shardTaskListRun(taskList)){
+        return false;
+    }
+
+    //按主键更新时 没有命中视为主键值不存在
+    if(primarykeyValue.isValid()&&taskList.first().affectedNum==0){
+        m_errorInfo = "[EasySQLite/Error]分片表字段更新报错: 条件字段值不存在";
+        return false;
+    }
+    return true;
+}
+
+/*
+ *  @brief  分片表按主键取值
+ *  @param  表格名
+ *  @param  主键值
+ *  @param  字段名
+ *  @param  字段值(输出)
+ *  @retval 是否获取成功
+ */
+bool EasySQLite::shardValue(const QString &tableName, const QVariant &primarykeyValue, const QString &fieldName, QVariant &value){
+    if(!m_shardFieldNameHash.value(tableName).contains(fieldName)){
+        m_errorInfo = "[EasySQLite/Error]分片表获取数值报错: 字段名不存在";
+        return false;
+    }
+
+    QList<ShardTask> taskList(1);
+    taskList[0].shardIndex = shardIndex(primarykeyValue,m_shardNumHash.value(tableName));
+    taskList[0].isSelect = true;
+    taskList[0].sqlList.append(QString("SELECT %1 FROM %2 WHERE %3 = %4").arg(fieldName).arg(tableName)
+                                   .arg(m_shardPrimarykeyHash.value(tableName)).arg(value2SqlFormat(primarykeyValue)));
+    if(!shardTaskListRun(taskList)){
+        return false;
+    }
+    if(taskList.first().rowList.isEmpty()){
+        m_errorInfo = "[EasySQLite/Error]分片表获取数值报错: 主键值不存在";
+        return false;
+    }
+    value = taskList.first().rowList.first().first();
+    return true;
+}
+
+/*
+ *  @brief  判断表格是否为分片表
+ *  @param  表格名
+ *  @retval 是否为分片表
+ */
+bool EasySQLite::isShardedTable(const QString &tableName){
+    return m_shardNumHash.contains(tableName);
+}
+
+/*
+ *  @brief  获取最近一次分片表查询的归并结果
+ *  @param  无
+ *  @retval 结果行列表 分片表不经过QSqlTableModel recordSelect/recordSelectTableAll查询分片表后返回false 结果从这里获取
+ */
+QList<QVariantList> EasySQLite::shardRecords(){
+    return m_shardRecordList;
+}
+
+/*
+ *  @brief  获取最近一次分片表查询结果的字段名
+ *  @param  无
+ *  @retval 字段名列表
+ */
+QStringList EasySQLite::shardFieldNames(){
+    return m_shardRecordFieldNameList;
+}
+
+/*
+ *  @brief  按主键值查询行的rowid
+ *  @param  表格名
+ *  @param  主键值
+ *  @param  rowid(输出)
+ *  @retval 是否查询成功 主键值不存在视为失败
+ */
+bool EasySQLite::blobRowid(const QString &tableName, const QVariant &primarykeyValue, qint64 &rowid){
+    QString primaryName = primarykeyName(tableName);
+    if(primaryName==""){
+        m_errorInfo = "[EasySQLite/Error]BLOB定位报错: 查询主键名错误";
+        return false;
+    }
+
+    QSqlQuery query;
+    if(!queryExec(query,QString("SELECT rowid FROM %1 WHERE %2 = %3").arg(tableName).arg(primaryName).arg(value2SqlFormat(primarykeyValue)))){
+        m_errorInfo = "[EasySQLite/Error]BLOB定位报错: 执行SQL语句查询rowid错误" + query.lastError().text();
+        return false;
+    }
+    if(!query.next()){
+        m_errorInfo = "[EasySQLite/Error]BLOB定位报错: 主键值不存在";
+        return false;
+    }
+    rowid = query.value(0).toLongLong();
+    return true;
+}
+
+/*
+ *  @brief  通过sqlite3_blob按固定块大小在字段与设备之间流式拷贝
+ *  @param  表格名
+ *  @param  BLOB字段名
+ *  @param  行rowid
+ *  @param  读写设备
+ *  @param  true: 设备->字段 字段需已用zeroblob()预留好长度  false: 字段->设备
+ *  @retval 是否拷贝成功
+ */
+bool EasySQLite::blobStream(const QString &tableName, const QString &fieldName, qint64 rowid,
+                            QIODevice *device, bool isWrite){
+    //不经过queryExec 在此记录活动时间 避免后台维护在读写期间执行
+    m_lastActivityTime = QDateTime::currentMSecsSinceEpoch();
+
+    sqlite3* handle = sqliteHandle(m_database);
+    if(handle==nullptr){
+        m_errorInfo = "[EasySQLite/Error]BLOB流式读写报错: 获取sqlite3句柄失败";
+        return false;
+    }
+
+    //打开BLOB句柄
+    sqlite3_blob* blob = nullptr;
+    if(sqlite3_blob_open(handle,"main",tableName.toUtf8().constData(),fieldName.toUtf8().constData(),
+                          rowid,isWrite?1:0,&blob)!=SQLITE_OK){
+        m_errorInfo = "[EasySQLite/Error]BLOB流式读写报错: " + QString::fromUtf8(sqlite3_errmsg(handle));
+        sqlite3_blob_close(blob);
+        return false;
+    }
+
+    //按块拷贝 内存占用固定为一个块
+    qint64 totalSize = sqlite3_blob_bytes(blob);
+    QByteArray buffer(m_blobChunkSize,Qt::Uninitialized);
+    for (qint64 offset = 0; offset < totalSize; ) {
+        qint64 chunkSize = qMin(static_cast<qint64>(m_blobChunkSize),totalSize-offset);
+        int ret = SQLITE_OK;
+        if(isWrite){
+            if(device->read(buffer.data(),chunkSize)!=chunkSize){
+                m_errorInfo = "[EasySQLite/Error]BLOB流式读写报错: 设备读取失败 " + device->errorString();
+                sqlite3_blob_close(blob);
+                return false;
+            }
+            ret = sqlite3_blob_write(blob,buffer.constData(),static_cast<int>(chunkSize),static_cast<int>(offset));
+        }else{
+            ret = sqlite3_blob_read(blob,buffer.data(),static_cast<int>(chunkSize),static_cast<int>(offset));
+            if(ret==SQLITE_OK&&device->write(buffer.constData(),chunkSize)!=chunkSize){
+                m_errorInfo = "[EasySQLite/Error]BLOB流式读写报错: 设备写入失败 " + device->errorString();
+                sqlite3_blob_close(blob);
+                return false;
+            }
+        }
+        if(ret!=SQLITE_OK){
+            m_errorInfo = "[EasySQLite/Error]BLOB流式读写报错: " + QString::fromUtf8(sqlite3_errmsg(handle));
+            sqlite3_blob_close(blob);
+            return false;
+        }
+        offset += chunkSize;
+    }
+
+    //关闭BLOB句柄
+    if(sqlite3_blob_close(blob)!=SQLITE_OK){
+        m_errorInfo = "[EasySQLite/Error]BLOB流式读写报错: " + QString::fromUtf8(sqlite3_errmsg(handle));
+        return false;
+    }
+    return true;
+}
+
+/*
+ *  @brief  插入整行记录 BLOB字段用zeroblob()预留后从设备流式写入
+ *  @param  表格名
+ *  @param  插入数据参数 BLOB字段位置的值会被忽略
+ *  @param  BLOB字段名
+ *  @param  数据来源设备 需已打开且支持随机访问 从当前位置读到末尾
+ *  @retval 是否插入成功
+ */
+bool EasySQLite::recordInsertBlob(const QString &tableName, const QVariantList &values,
+                                  const QString &blobFieldName, QIODevice *device){
+    TraceScope trace(this,TraceMethod::RecordInsertBlob,tableName,values,blobFieldName,device);
+
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("BLOB记录插入")){
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]BLOB记录插入报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //数据库已打开 判断表格是否存在
+    if (!m_database.tables().contains(tableName)) {
+        m_errorInfo = "[EasySQLite/Error]BLOB记录插入报错: 表格不存在";
+        return false;
+    }
+
+    //判断设备是否可读且长度已知
+    if(device==nullptr||!device->isReadable()||device->isSequential()){
+        m_errorInfo = "[EasySQLite/Error]BLOB记录插入报错: 设备不可读或不支持随机访问";
+        return false;
+    }
+
+    //定位BLOB字段
+    QStringList tableFieldNameList;
+    if(!fieldNameQuery(tableName,tableFieldNameList)){
+        m_errorInfo = "[EasySQLite/Error]BLOB记录插入报错: 查询字段名列表错误";
+        return false;
+    }
+    int blobIndex = tableFieldNameList.indexOf(blobFieldName);
+    if(blobIndex<0||blobIndex>=values.size()){
+        m_errorInfo = "[EasySQLite/Error]BLOB记录插入报错: BLOB字段名不存在";
+        return false;
+    }
+
+    //BLOB字段替换为zeroblob() 数据不经过SQL文本
+    QStringList strValueList;
+    for (int var = 0; var < values.size(); ++var) {
+        if(var==blobIndex){
+            strValueList.append(QString("zeroblob(%1)").arg(device->size()-device->pos()));
+        }else{
+            strValueList.append(value2SqlFormat(values.at(var)));
+        }
+    }
+
+    //插入与写入放在同一事务 写入失败时不留下半截记录 调用方事务中时为保存点
+    if(!transactionBegin()){
+        return false;
+    }
+    QSqlQuery query;
+    if(!queryExec(query,QString("INSERT INTO %1 VALUES(%2)").arg(tableName).arg(strValueList.join(",")))){
+        m_errorInfo = "[EasySQLite/Error]BLOB记录插入报错: 执行SQL语句插入数据错误" + query.lastError().text();
+        QString errorInfo = m_errorInfo;
+        transactionRollback();
+        m_errorInfo = errorInfo;
+        return false;
+    }
+    if(!blobStream(tableName,blobFieldName,query.lastInsertId().toLongLong(),device,true)){
+        QString errorInfo = m_errorInfo;
+        transactionRollback();
+        m_errorInfo = errorInfo;
+        return false;
+    }
+    query.finish();
+    if(!transactionCommit()){
+        QString errorInfo = m_errorInfo;
+        transactionRollback();
+        m_errorInfo = errorInfo;
+        return false;
+    }
+
+    //插入成功 关闭数据库
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  用设备内容覆盖已有记录的BLOB字段
+ *  @param  表格名
+ *  @param  主键值
+ *  @param  BLOB字段名
+ *  @param  数据来源设备 需已打开且支持随机访问 从当前位置读到末尾
+ *  @retval 是否写入成功
+ */
+bool EasySQLite::blobWrite(const QString &tableName, const QVariant &primarykeyValue,
+                           const QString &blobFieldName, QIODevice *device){
+    TraceScope trace(this,TraceMethod::BlobWrite,tableName,primarykeyValue,blobFieldName,device);
+
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("BLOB写入")){
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]BLOB写入报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //数据库已打开 判断表格是否存在
+    if (!m_database.tables().contains(tableName)) {
+        m_errorInfo = "[EasySQLite/Error]BLOB写入报错: 表格不存在";
+        return false;
+    }
+
+    //判断设备是否可读且长度已知
+    if(device==nullptr||!device->isReadable()||device->isSequential()){
+        m_errorInfo = "[EasySQLite/Error]BLOB写入报错: 设备不可读或不支持随机访问";
+        return false;
+    }
+
+    //定位记录
+    qint64 rowid = 0;
+    if(!blobRowid(tableName,primarykeyValue,rowid)){
+        return false;
+    }
+
+    //先用zeroblob()预留长度 再流式写入 调用方事务中时为保存点
+    if(!transactionBegin()){
+        return false;
+    }
+    QSqlQuery query;
+    if(!queryExec(query,QString("UPDATE %1 SET %2 = zeroblob(%3) WHERE rowid = %4").arg(tableName).arg(blobFieldName)
+                        .arg(device->size()-device->pos()).arg(rowid))){
+        m_errorInfo = "[EasySQLite/Error]BLOB写入报错: 执行SQL语句预留空间错误" + query.lastError().text();
+        QString errorInfo = m_errorInfo;
+        transactionRollback();
+        m_errorInfo = errorInfo;
+        return false;
+    }
+    if(!blobStream(tableName,blobFieldName,rowid,device,true)){
+        QString errorInfo = m_errorInfo;
+        transactionRollback();
+        m_errorInfo = errorInfo;
+        return false;
+    }
+    query.finish();
+    if(!transactionCommit()){
+        QString errorInfo = m_errorInfo;
+        transactionRollback();
+        m_errorInfo = errorInfo;
+        return false;
+    }
+
+    //写入成功 关闭数据库
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  把记录的BLOB字段流式读出到设备
+ *  @param  表格名
+ *  @param  主键值
+ *  @param  BLOB字段名
+ *  @param  目标设备 需已打开且可写
+ *  @retval 是否读取成功
+ */
+bool EasySQLite::blobRead(const QString &tableName, const QVariant &primarykeyValue,
+                          const QString &blobFieldName, QIODevice *device){
+    TraceScope trace(this,TraceMethod::BlobRead,tableName,primarykeyValue,blobFieldName);
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]BLOB读取报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //数据库已打开 判断表格是否存在
+    if (!m_database.tables().contains(tableName)) {
+        m_errorInfo = "[EasySQLite/Error]BLOB读取报错: 表格不存在";
+        return false;
+    }
+
+    //判断设备是否可写
+    if(device==nullptr||!device->isWritable()){
+        m_errorInfo = "[EasySQLite/Error]BLOB读取报错: 设备不可写";
+        return false;
+    }
+
+    //定位记录并读取
+    qint64 rowid = 0;
+    if(!blobRowid(tableName,primarykeyValue,rowid)||!blobStream(tableName,blobFieldName,rowid,device,false)){
+        return false;
+    }
+
+    //读取成功 关闭数据库
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  设置BLOB流式读写的块大小
+ *  @param  块大小(字节)
+ *  @retval 无
+ */
+void EasySQLite::setBlobChunkSize(int size){
+    if(size>0){
+        m_blobChunkSize = size;
+    }
+}
+
+/*
+ *  @brief  为表格创建trigram分词的FTS5外部内容影子表及同步触发器
+ *  @param  表格名
+ *  @param  全文检索字段名列表
+ *  @retval 是否创建成功
+ *  @note   影子表名为 表格名_fts 首次创建时用已有数据重建索引
+ */
+bool EasySQLite::searchTableInit(const QString &tableName, const QStringList &searchFieldNameList){
+    //默认数据库已打开 判断表格与字段是否存在
+    QStringList tableFieldNameList;
+    if(!fieldNameQuery(tableName,tableFieldNameList)){
+        m_errorInfo = "[EasySQLite/Error]全文检索初始化报错: 表格不存在";
+        return false;
+    }
+    for (int var = 0; var < searchFieldNameList.size(); ++var) {
+        if(!tableFieldNameList.contains(searchFieldNameList.at(var))){
+            m_errorInfo = "[EasySQLite/Error]全文检索初始化报错: 字段名不存在";
+            return false;
+        }
+    }
+
+    //拼接字段列表
+    QString ftsName = tableName+"_fts";
+    QString fields = searchFieldNameList.join(",");
+    QString newFields = "new."+searchFieldNameList.join(",new.");
+    QString oldFields = "old."+searchFieldNameList.join(",old.");
+    bool isExist = m_database.tables().contains(ftsName);
+
+    QStringList sqlList;
+    sqlList.append(QString("CREATE VIRTUAL TABLE IF NOT EXISTS %1 USING fts5(%2, content='%3', content_rowid='rowid', tokenize='trigram')")
+                       .arg(ftsName).arg(fields).arg(tableName));
+    sqlList.append(QString("CREATE TRIGGER IF NOT EXISTS %1_ai AFTER INSERT ON %2 BEGIN "
+                           "INSERT INTO %1(rowid,%3) VALUES(new.rowid,%4); END")
+                       .arg(ftsName).arg(tableName).arg(fields).arg(newFields));
+    sqlList.append(QString("CREATE TRIGGER IF NOT EXISTS %1_ad AFTER DELETE ON %2 BEGIN "
+                           "INSERT INTO %1(%1,rowid,%3) VALUES('delete',old.rowid,%4); END")
+                       .arg(ftsName).arg(tableName).arg(fields).arg(oldFields));
+    sqlList.append(QString("CREATE TRIGGER IF NOT EXISTS %1_au AFTER UPDATE ON %2 BEGIN "
+                           "INSERT INTO %1(%1,rowid,%3) VALUES('delete',old.rowid,%4); "
+                           "INSERT INTO %1(rowid,%3) VALUES(new.rowid,%5); END")
+                       .arg(ftsName).arg(tableName).arg(fields).arg(oldFields).arg(newFields));
+    if(!isExist){
+        //首次创建 用已有数据建立索引
+        sqlList.append(QString("INSERT INTO %1(%1) VALUES('rebuild')").arg(ftsName));
+    }
+
+    QSqlQuery query;
+    for (int var = 0; var < sqlList.size(); ++var) {
+        if(!queryExec(query,sqlList.at(var))){
+            m_errorInfo = "[EasySQLite/Error]全文检索初始化报错: 执行SQL语句错误" + query.lastError().text();
+            return false;
+        }
+    }
+
+    m_searchFieldHash.insert(tableName,searchFieldNameList);
+    return true;
+}
+
+/*
+ *  @brief  创建走FTS5索引的子串/后缀条件
+ *  @param  表格名
+ *  @param  是否为后缀匹配 否则为子串匹配
+ *  @param  是否取反
+ *  @param  条件字段名
+ *  @param  条件字段值
+ *  @retval 条件字符串 例: rowid IN (SELECT rowid FROM t_fts WHERE name MATCH '"abc"') AND name like '%abc'
+ *  @note   trigram至少需要3个字符 更短的值退回LIKE 调用方保证值中不含LIKE通配符
+ *          取反时与NOT LIKE一致 字段为NULL的行不匹配
+ */
+QString EasySQLite::searchConditionCreate(const QString &tableName, bool isSuffix, bool isNot,
+                                          const QString &condiFieldName, const QString &condiFieldValue){
+    QString likeValue = condiFieldValue;
+    likeValue.replace("'","''");
+    QString like = isSuffix?QString("%1 like '%%2'").arg(condiFieldName).arg(likeValue)
+                            :QString("%1 like '%%2%'").arg(condiFieldName).arg(likeValue);
+
+    QString ret = like;
+    if(condiFieldValue.size()>=3){
+        //短语查询 双引号内的双引号需转义
+        QString matchValue = condiFieldValue;
+        matchValue.replace("\"","\"\"");
+        matchValue.replace("'","''");
+        QString match = QString("rowid IN (SELECT rowid FROM %1_fts WHERE %2 MATCH '\"%3\"')")
+                            .arg(tableName).arg(condiFieldName).arg(matchValue);
+
+        //子串匹配由MATCH精确完成 后缀匹配在候选行上再用LIKE过滤
+        ret = isSuffix?(match+" AND "+like):match;
+    }
+
+    if(isNot){
+        ret = QString("%1 IS NOT NULL AND NOT (%2)").arg(condiFieldName,ret);
+    }
+    return "("+ret+")";
+}
+
+/*
+ *  @brief  直接从sqlite3语句逐行读取到列式存储 不经过QVariant
+ *  @param  已准备好的sqlite3语句
+ *  @retval 是否读取成功
+ */
+bool EasySQLiteResultSet::load(sqlite3_stmt *statement){
+    clear();
+
+    //建立列
+    int columnNum = sqlite3_column_count(statement);
+    m_columnList.resize(columnNum);
+    for (int column = 0; column < columnNum; ++column) {
+        m_columnList[column].name = QString::fromUtf8(sqlite3_column_name(statement,column));
+    }
+
+    //逐行读取
+    int ret;
+    while((ret = sqlite3_step(statement))==SQLITE_ROW){
+        for (int column = 0; column < columnNum; ++column) {
+            Column& current = m_columnList[column];
+            qint64 slot = 0;
+            quint32 length = 0;
+            Type cellType = Type::Null;
+            switch (sqlite3_column_type(statement,column)) {
+            case SQLITE_INTEGER:
+                cellType = Type::Integer;
+                slot = sqlite3_column_int64(statement,column);
+                break;
+            case SQLITE_FLOAT:{
+                cellType = Type::Real;
+                double real = sqlite3_column_double(statement,column);
+                memcpy(&slot,&real,sizeof(slot));
+                break;
+            }
+            case SQLITE_TEXT:{
+                //文本以UTF-16存入池 保证2字节对齐 便于零拷贝QStringView
+                cellType = Type::Text;
+                const void* text = sqlite3_column_text16(statement,column);
+                length = static_cast<quint32>(sqlite3_column_bytes16(statement,column));
+                if(m_pool.size()%2){
+                    m_pool.append('\0');
+                }
+                slot = m_pool.size();
+                m_pool.append(static_cast<const char*>(text),length);
+                break;
+            }
+            case SQLITE_BLOB:{
+                cellType = Type::Blob;
+                const void* blob = sqlite3_column_blob(statement,column);
+                length = static_cast<quint32>(sqlite3_column_bytes(statement,column));
+                slot = m_pool.size();
+                m_pool.append(static_cast<const char*>(blob),length);
+                break;
+            }
+            default:
+                break;
+            }
+            current.typeList.append(cellType);
+            current.slotList.append(slot);
+            current.lengthList.append(length);
+        }
+        m_rowNum++;
+    }
+    return ret==SQLITE_DONE;
+}
+
+/*
+ *  @brief  获取整数单元格 Real单元格会截断
+ *  @param  行
+ *  @param  列
+ *  @retval 整数值 NULL/文本/BLOB返回0
+ */
+qint64 EasySQLiteResultSet::toInteger(int row, int column) const{
+    const Column& current = m_columnList.at(column);
+    switch (current.typeList.at(row)) {
+    case Type::Integer:
+        return current.slotList.at(row);
+    case Type::Real:
+        return static_cast<qint64>(toReal(row,column));
+    default:
+        return 0;
+    }
+}
+
+/*
+ *  @brief  获取浮点单元格 Integer单元格会转换
+ *  @param  行
+ *  @param  列
+ *  @retval 浮点值 NULL/文本/BLOB返回0
+ */
+double EasySQLiteResultSet::toReal(int row, int column) const{
+    const Column& current = m_columnList.at(column);
+    switch (current.typeList.at(row)) {
+    case Type::Integer:
+        return static_cast<double>(current.slotList.at(row));
+    case Type::Real:{
+        double real;
+        qint64 slot = current.slotList.at(row);
+        memcpy(&real,&slot,sizeof(real));
+        return real;
+    }
+    default:
+        return 0;
+    }
+}
+
+/*
+ *  @brief  零拷贝获取文本单元格
+ *  @param  行
+ *  @param  列
+ *  @retval 指向字符串池的视图 结果集销毁或清空后失效 非文本返回空视图
+ */
+QStringView EasySQLiteResultSet::toText(int row, int column) const{
+    const Column& current = m_columnList.at(column);
+    if(current.typeList.at(row)!=Type::Text){
+        return QStringView();
+    }
+    return QStringView(reinterpret_cast<const QChar*>(m_pool.constData()+current.slotList.at(row)),
+                       current.lengthList.at(row)/2);
+}
+
+/*
+ *  @brief  零拷贝获取BLOB单元格
+ *  @param  行
+ *  @param  列
+ *  @retval 指向字符串池的视图 结果集销毁或清空后失效 非BLOB返回空视图
+ */
+QByteArrayView EasySQLiteResultSet::toBlob(int row, int column) const{
+    const Column& current = m_columnList.at(column);
+    if(current.typeList.at(row)!=Type::Blob){
+        return QByteArrayView();
+    }
+    return QByteArrayView(m_pool.constData()+current.slotList.at(row),current.lengthList.at(row));
+}
+
+/*
+ *  @brief  获取结果集占用的内存
+ *  @param  无
+ *  @retval 字符串池与各列定长数组的字节数
+ */
+qint64 EasySQLiteResultSet::memoryUsage() const{
+    qint64 ret = m_pool.size();
+    for (int column = 0; column < m_columnList.size(); ++column) {
+        ret += static_cast<qint64>(m_columnList.at(column).typeList.size())*(sizeof(Type)+sizeof(qint64)+sizeof(quint32));
+    }
+    return ret;
+}
+
+/*
+ *  @brief  以QVariant形式获取单元格 会产生拷贝 仅用于兼容
+ *  @param  行
+ *  @param  列
+ *  @retval 单元格值
+ */
+QVariant EasySQLiteResultSet::value(int row, int column) const{
+    switch (type(row,column)) {
+    case Type::Integer:
+        return toInteger(row,column);
+    case Type::Real:
+        return toReal(row,column);
+    case Type::Text:
+        return toText(row,column).toString();
+    case Type::Blob:
+        return toBlob(row,column).toByteArray();
+    default:
+        return QVariant();
+    }
+}
+
+/*
+ *  @brief  记录查询 结果直接读入列式结果集 不创建QSqlTableModel
+ *  @param  表格名
+ *  @param  查询字段名列表
+ *  @param  条件字符串 可为空
+ *  @param  排序字段名
+ *  @param  排序策略
+ *  @param  结果集(输出)
+ *  @retval 是否查询成功
+ */
+bool EasySQLite::recordSelect(const QString &tableName, const QStringList &fieldNameList, const QString &condition,
+                              const QString &sortFieldName, const SortPolicy &sortPolicy, ESResultSet &resultSet){
+    TraceScope trace(this,TraceMethod::RecordSelectResultSet,tableName,fieldNameList,condition,sortFieldName,sortPolicy);
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]结果集查询报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //数据库已打开 判断表格是否存在
+    if (!m_database.tables().contains(tableName)) {
+        m_errorInfo = "[EasySQLite/Error]结果集查询报错: 表格不存在";
+        return false;
+    }
+
+    //查询结果缓存 依赖表格未被写入时直接复用上次的结果集 结果集隐式共享不产生拷贝
+    QString cacheKey;
+    QList<quint64> versionList;
+    if(isResultCacheable()){
+        cacheKey = QString("R|SELECT %1 FROM %2 WHERE %3 ORDER BY %4 %5").arg(fieldNameList.join(","),tableName,condition,sortFieldName)
+                       .arg(sortPolicy==SortPolicy::ASC?"ASC":"DESC").simplified();
+        versionList = resultCacheVersions(tableName,condition);
+        ResultCacheEntry* entry = resultCacheFind(cacheKey,versionList);
+        if(entry!=nullptr){
+            resultSet = entry->resultSet;
+            databaseClose();
+            return true;
+        }
+    }
+
+    //一次性获取全部字段名 校验查询字段与排序字段
+    QStringList tableFieldNameList;
+    if(!fieldNameQuery(tableName,tableFieldNameList)){
+        m_errorInfo = "[EasySQLite/Error]结果集查询报错: 查询字段名列表错误";
+        return false;
+    }
+    for (int var = 0; var < fieldNameList.size(); ++var) {
+        if(!tableFieldNameList.contains(fieldNameList.at(var))){
+            m_errorInfo = "[EasySQLite/Error]结果集查询报错: 查询字段名不存在";
+            return false;
+        }
+    }
+    if(!tableFieldNameList.contains(sortFieldName)){
+        m_errorInfo = "[EasySQLite/Error]结果集查询报错: 排序字段名不存在";
+        return false;
+    }
+
+    //制作查询语句
+    QString strCondition;
+    if(!condition.isEmpty()){
+        strCondition = "WHERE "+condition;
+    }
+    QString policy = (sortPolicy==SortPolicy::ASC)?"ASC":"DESC";
+    QByteArray sql = QString("SELECT %1 FROM %2 %3 ORDER BY %4 %5").arg(fieldNameList.join(",")).arg(tableName)
+                         .arg(strCondition).arg(sortFieldName).arg(policy).toUtf8();
+
+    //绕过QSqlQuery 直接用sqlite3语句读取 不经过queryExec 在此记录活动时间
+    m_lastActivityTime = QDateTime::currentMSecsSinceEpoch();
+    sqlite3* handle = sqliteHandle(m_database);
+    sqlite3_stmt* statement = nullptr;
+    if(handle==nullptr||sqlite3_prepare_v2(handle,sql.constData(),static_cast<int>(sql.size()),&statement,nullptr)!=SQLITE_OK){
+        m_errorInfo = "[EasySQLite/Error]结果集查询报错: 准备SQL语句错误" + QString::fromUtf8(handle?sqlite3_errmsg(handle):"");
+        sqlite3_finalize(statement);
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    bool isSuccess = resultSet.load(statement);
+    sqlite3_finalize(statement);
+    if(!isSuccess){
+        m_errorInfo = "[EasySQLite/Error]结果集查询报错: 执行SQL语句查询错误" + QString::fromUtf8(sqlite3_errmsg(handle));
+        return false;
+    }
+    if(!resultSetDecompress(tableName,resultSet)){
+        resultSet.clear();
+        return false;
+    }
+    slowQueryRecord(QString::fromUtf8(sql),QVariantList(),timer.nsecsElapsed()/1000,resultSet.rowCount(),handle);
+
+    //加入缓存
+    if(!cacheKey.isEmpty()){
+        ResultCacheEntry entry;
+        entry.versionList = versionList;
+        entry.resultSet = resultSet;
+        entry.cost = resultSet.memoryUsage();
+        resultCacheInsert(cacheKey,entry);
+    }
+
+    //查询成功 关闭数据库
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  获取表格的字段名与主键名 首次查询后缓存
+ *  @param  表格名
+ *  @param  表格结构(输出)
+ *  @retval 是否获取成功
+ */
+bool EasySQLite::tableSchema(const QString &tableName, TableSchema &schema){
+    //命中缓存
+    if(m_schemaHash.contains(tableName)){
+        schema = m_schemaHash.value(tableName);
+        return true;
+    }
+
+    //默认数据库已打开 查询字段名与主键名
+    if(!fieldNameQuery(tableName,schema.fieldNameList)){
+        return false;
+    }
+    schema.primarykeyName = primarykeyName(tableName);
+    m_schemaHash.insert(tableName,schema);
+    return true;
+}
+
+/*
+ *  @brief  从读连接池中取出一个空闲的只读连接 没有则新建
+ *  @param  错误信息(输出)
+ *  @retval sqlite3只读句柄 失败返回nullptr
+ *  @note   线程池线程数等于连接池大小 因此连接数不会超过连接池大小
+ */
+sqlite3* EasySQLite::readHandleAcquire(QString &errorInfo){
+    QMutexLocker locker(&m_readHandleMutex);
+    if(!m_idleReadHandleList.isEmpty()){
+        return m_idleReadHandleList.takeLast();
+    }
+
+    //新建只读连接 共享缓存内存库需要URI方式打开 immutable只读模式的库名即带immutable=1的URI
+    sqlite3* handle = nullptr;
+    if(sqlite3_open_v2(m_database.databaseName().toUtf8().constData(),&handle,
+                        SQLITE_OPEN_READONLY|SQLITE_OPEN_NOMUTEX|SQLITE_OPEN_URI,nullptr)!=SQLITE_OK){
+        errorInfo = "[EasySQLite/Error]并行读报错: 只读连接打开失败 " + QString::fromUtf8(sqlite3_errmsg(handle));
+        sqlite3_close(handle);
+        return nullptr;
+    }
+    sqlite3_busy_timeout(handle,m_busyTimeout);
+    //只读模式 与主连接使用相同的mmap与query_only设置
+    if(m_readOnlyMode){
+        QByteArray sql = QString("PRAGMA mmap_size = %1; PRAGMA query_only = ON;").arg(m_mmapSize).toUtf8();
+        if(sqlite3_exec(handle,sql.constData(),nullptr,nullptr,nullptr)!=SQLITE_OK){
+            errorInfo = "[EasySQLite/Error]并行读报错: 只读连接设置失败 " + QString::fromUtf8(sqlite3_errmsg(handle));
+            sqlite3_close(handle);
+            return nullptr;
+        }
+    }
+    m_readHandleList.append(handle);
+    return handle;
+}
+
+/*
+ *  @brief  把只读连接归还到读连接池
+ *  @param  sqlite3只读句柄
+ *  @retval 无
+ */
+void EasySQLite::readHandleRelease(sqlite3 *handle){
+    QMutexLocker locker(&m_readHandleMutex);
+    m_idleReadHandleList.append(handle);
+}
+
+/*
+ *  @brief  在工作线程中执行单个读操作
+ *  @param  读操作
+ *  @param  已校验过的表格结构
+ *  @param  读结果(输出)
+ *  @retval 无
+ */
+void EasySQLite::readExec(const ESRead &read, const TableSchema &schema, ESReadResult &result){
+    //制作查询语句
+    QString sql;
+    if(read.kind==ESRead::Kind::Select){
+        QString strCondition;
+        if(!read.condition.isEmpty()){
+            strCondition = "WHERE "+read.condition;
+        }
+        QString policy = (read.sortPolicy==SortPolicy::ASC)?"ASC":"DESC";
+        sql = QString("SELECT %1 FROM %2 %3 ORDER BY %4 %5").arg(read.fieldNameList.join(",")).arg(read.tableName)
+                  .arg(strCondition).arg(read.sortFieldName).arg(policy);
+    }else{
+        sql = QString("SELECT %1 FROM %2 WHERE %3 = %4").arg(read.fieldNameList.first()).arg(read.tableName)
+                  .arg(schema.primarykeyName).arg(value2SqlFormat(read.primarykeyValue));
+    }
+
+    //取连接执行
+    sqlite3* handle = readHandleAcquire(result.errorInfo);
+    if(handle==nullptr){
+        return;
+    }
+    QByteArray strSql = sql.toUtf8();
+    sqlite3_stmt* statement = nullptr;
+    QElapsedTimer timer;
+    timer.start();
+    if(sqlite3_prepare_v2(handle,strSql.constData(),static_cast<int>(strSql.size()),&statement,nullptr)!=SQLITE_OK
+        ||!result.resultSet.load(statement)){
+        result.errorInfo = "[EasySQLite/Error]并行读报错: 执行SQL语句查询错误" + QString::fromUtf8(sqlite3_errmsg(handle));
+        sqlite3_finalize(statement);
+        readHandleRelease(handle);
+        return;
+    }
+    sqlite3_finalize(statement);
+    slowQueryRecord(sql,QVariantList(),timer.nsecsElapsed()/1000,result.resultSet.rowCount(),handle);
+    readHandleRelease(handle);
+
+    //按主键取值
+    if(read.kind==ESRead::Kind::Value){
+        if(result.resultSet.rowCount()==0){
+            result.errorInfo = "[EasySQLite/Error]并行读报错: 主键值不存在";
+            return;
+        }
+        result.value = result.resultSet.value(0,0);
+        result.resultSet.clear();
+    }
+    result.isSuccess = true;
+}
+
+/*
+ *  @brief  在只读连接池上并行执行一批读操作
+ *  @param  读操作列表
+ *  @param  读结果列表(输出) 与读操作一一对应 保持输入顺序
+ *  @retval 是否全部成功 失败原因见各结果的errorInfo
+ */
+bool EasySQLite::readParallel(const QList<ESRead> &readList, QList<ESReadResult> &resultList){
+    TraceScope trace(this,TraceMethod::ReadParallel,QString(),readList);
+    m_lastActivityTime = QDateTime::currentMSecsSinceEpoch();
+
+    if(m_readPool==nullptr){
+        m_errorInfo = "[EasySQLite/Error]并行读报错: 未启用读连接池";
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]并行读报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //在调用线程统一校验 工作线程只执行SQL
+    resultList = QList<ESReadResult>(readList.size());
+    QList<TableSchema> schemaList(readList.size());
+    QList<int> validIndexList;
+    for (int var = 0; var < readList.size(); ++var) {
+        const ESRead& read = readList.at(var);
+        if(!m_database.tables().contains(read.tableName)||!tableSchema(read.tableName,schemaList[var])){
+            resultList[var].errorInfo = "[EasySQLite/Error]并行读报错: 表格不存在";
+            continue;
+        }
+        const QStringList& tableFieldNameList = schemaList.at(var).fieldNameList;
+        bool isValid = !read.fieldNameList.isEmpty();
+        for (int index = 0; index < read.fieldNameList.size(); ++index) {
+            isValid = isValid&&tableFieldNameList.contains(read.fieldNameList.at(index));
+        }
+        if(read.kind==ESRead::Kind::Select){
+            isValid = isValid&&tableFieldNameList.contains(read.sortFieldName);
+        }
+        if(!isValid){
+            resultList[var].errorInfo = "[EasySQLite/Error]并行读报错: 字段名不存在";
+            continue;
+        }
+        validIndexList.append(var);
+    }
+
+    //分发到线程池 各任务只写自己的结果
+    QList<QFuture<void>> futureList;
+    for (int var = 0; var < validIndexList.size(); ++var) {
+        int index = validIndexList.at(var);
+        const ESRead* read = &readList.at(index);
+        const TableSchema* schema = &schemaList.at(index);
+        ESReadResult* result = &resultList[index];
+        futureList.append(QtConcurrent::run(m_readPool,[this,read,schema,result](){readExec(*read,*schema,*result);}));
+    }
+    for (int var = 0; var < futureList.size(); ++var) {
+        futureList[var].waitForFinished();
+    }
+
+    //解压在调用线程进行 压缩统计与错误信息不跨线程写
+    for (int var = 0; var < validIndexList.size(); ++var) {
+        int index = validIndexList.at(var);
+        const ESRead& read = readList.at(index);
+        ESReadResult& result = resultList[index];
+        if(!result.isSuccess||!m_compressHash.contains(read.tableName)){
+            continue;
+        }
+        bool isDecompressed = (read.kind==ESRead::Kind::Value)?decompressValue(read.tableName,read.fieldNameList.first(),result.value)
+                                                                 :resultSetDecompress(read.tableName,result.resultSet);
+        if(!isDecompressed){
+            result.isSuccess = false;
+            result.errorInfo = m_errorInfo;
+        }
+    }
+
+    //汇总
+    databaseClose();
+    for (int var = 0; var < resultList.size(); ++var) {
+        if(!resultList.at(var).isSuccess){
+            m_errorInfo = resultList.at(var).errorInfo;
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ *  @brief  执行SQL语句并计时 超过慢查询阈值时记录
+ *          SELECT计时到取得第一行为止 QSQLITE在exec()中即执行到第一行 不改变调用方的游标设置 行数记为-1
+ *  @param  默认连接上的查询对象
+ *  @param  SQL语句 为空时执行已prepare的语句
+ *  @retval 是否执行成功
+ */
+bool EasySQLite::queryExec(QSqlQuery &query, const QString &sql){
+    m_lastActivityTime = QDateTime::currentMSecsSinceEpoch();
+
+    //建表/删除/修改表格结构 缓存的表结构失效
+    if(sql.startsWith("CREATE",Qt::CaseInsensitive)||sql.startsWith("DROP",Qt::CaseInsensitive)
+        ||sql.startsWith("ALTER",Qt::CaseInsensitive)){
+        m_schemaHash.clear();
+    }
+
+    //删除/修改表格结构不触发update钩子 使查询结果缓存全部失效
+    if(sql.startsWith("DROP",Qt::CaseInsensitive)||sql.startsWith("ALTER",Qt::CaseInsensitive)){
+        writeEpochBump();
+    }
+
+    //未开启慢查询日志 直接执行
+    if(m_slowQueryThreshold<0){
+        return busyRetryExec(query,sql);
+    }
+
+    //SELECT的exec()已执行到第一行 耗时即首行耗时 后续逐行取数由调用方进行 不在此计入
+    QElapsedTimer timer;
+    timer.start();
+    bool ret = busyRetryExec(query,sql);
+    qint64 duration = timer.nsecsElapsed()/1000;
+    if(ret){
+        slowQueryRecord(query.lastQuery(),query.boundValues(),duration,
+                        query.isSelect()?-1:query.numRowsAffected(),sqliteHandle(m_database));
+    }
+    return ret;
+}
+
+/*
+ *  @brief  判断耗时是否超过阈值 超过则连同EXPLAIN QUERY PLAN一起记录到环形缓冲区和日志文件
+ *  @param  SQL语句
+ *  @param  绑定值列表
+ *  @param  耗时(微秒)
+ *  @param  影响/返回行数 未知为-1
+ *  @param  执行该语句的sqlite3句柄 用于获取查询计划
+ *  @retval 无
+ *  @note   可能在并行读的工作线程中调用
+ */
+void EasySQLite::slowQueryRecord(const QString &sql, const QVariantList &bindValueList, qint64 duration,
+                                 int rowNum, sqlite3 *handle){
+    int threshold = m_slowQueryThreshold;
+    if(threshold<0||duration<static_cast<qint64>(threshold)*1000){
+        return;
+    }
+
+    ESSlowQuery slowQuery;
+    slowQuery.time = QDateTime::currentDateTime();
+    slowQuery.sql = sql;
+    slowQuery.bindValueList = bindValueList;
+    slowQuery.duration = duration;
+    slowQuery.rowNum = rowNum;
+
+    //获取查询计划 未绑定的参数按NULL处理不影响计划
+    QByteArray explain = ("EXPLAIN QUERY PLAN "+sql).toUtf8();
+    sqlite3_stmt* statement = nullptr;
+    if(handle!=nullptr&&sqlite3_prepare_v2(handle,explain.constData(),static_cast<int>(explain.size()),&statement,nullptr)==SQLITE_OK){
+        QStringList planList;
+        while(sqlite3_step(statement)==SQLITE_ROW){
+            //每行格式为 节点id|父节点id 计划描述
+            planList.append(QString("%1|%2 %3").arg(sqlite3_column_int(statement,0)).arg(sqlite3_column_int(statement,1))
+                                .arg(QString::fromUtf8(reinterpret_cast<const char*>(sqlite3_column_text(statement,3)))));
+        }
+        slowQuery.plan = planList.join("\n");
+    }
+    sqlite3_finalize(statement);
+
+    //写入环形缓冲区与日志文件
+    QMutexLocker locker(&m_slowQueryMutex);
+    m_slowQueryList.append(slowQuery);
+    while(m_slowQueryList.size()>m_slowQueryCapacity){
+        m_slowQueryList.removeFirst();
+    }
+    if(!m_slowQueryFilePath.isEmpty()){
+        QFile file(m_slowQueryFilePath);
+        if(file.open(QIODevice::WriteOnly|QIODevice::Append|QIODevice::Text)){
+            QTextStream stream(&file);
+            stream<<slowQueryFormat(slowQuery);
+        }
+    }
+}
+
+/*
+ *  @brief  把一条慢查询格式化为文本
+ *  @param  慢查询记录
+ *  @retval 多行文本
+ */
+QString EasySQLite::slowQueryFormat(const ESSlowQuery &slowQuery){
+    QStringList bindValueList;
+    for (int var = 0; var < slowQuery.bindValueList.size(); ++var) {
+        bindValueList.append(slowQuery.bindValueList.at(var).toString());
+    }
+    return QString("[EasySQLite/SlowQuery]%1 耗时%2us 行数%3\nSQL: %4\n绑定值: %5\n查询计划:\n%6\n\n")
+        .arg(slowQuery.time.toString(Qt::ISODateWithMs)).arg(slowQuery.duration).arg(slowQuery.rowNum)
+        .arg(slowQuery.sql).arg(bindValueList.join(", ")).arg(slowQuery.plan);
+}
+
+/*
+ *  @brief  设置慢查询阈值 开启/关闭慢查询日志
+ *  @param  阈值(毫秒) 负数表示关闭
+ *  @retval 无
+ */
+void EasySQLite::setSlowQueryThreshold(int msec){
+    m_slowQueryThreshold = msec;
+}
+
+/*
+ *  @brief  设置慢查询环形缓冲区容量
+ *  @param  最多保留的条数
+ *  @retval 无
+ */
+void EasySQLite::setSlowQueryCapacity(int capacity){
+    QMutexLocker locker(&m_slowQueryMutex);
+    m_slowQueryCapacity = qMax(capacity,1);
+    while(m_slowQueryList.size()>m_slowQueryCapacity){
+        m_slowQueryList.removeFirst();
+    }
+}
+
+/*
+ *  @brief  设置慢查询日志文件 每条记录追加写入
+ *  @param  文件路径 为空表示不写文件
+ *  @retval 无
+ */
+void EasySQLite::setSlowQueryFile(const QString &filePath){
+    QMutexLocker locker(&m_slowQueryMutex);
+    m_slowQueryFilePath = filePath;
+}
+
+/*
+ *  @brief  获取环形缓冲区中的慢查询记录
+ *  @param  无
+ *  @retval 慢查询记录 按时间先后排列
+ */
+QList<ESSlowQuery> EasySQLite::slowQueries(){
+    QMutexLocker locker(&m_slowQueryMutex);
+    return m_slowQueryList;
+}
+
+/*
+ *  @brief  把环形缓冲区中的慢查询格式化输出
+ *  @param  是否同时清空缓冲区
+ *  @retval 全部慢查询的文本
+ */
+QString EasySQLite::slowQueryDump(bool isClear){
+    QMutexLocker locker(&m_slowQueryMutex);
+    QString ret;
+    for (int var = 0; var < m_slowQueryList.size(); ++var) {
+        ret += slowQueryFormat(m_slowQueryList.at(var));
+    }
+    if(isClear){
+        m_slowQueryList.clear();
+    }
+    return ret;
+}
+
+/*
+ *  @brief  写操作后刷新TableModel 事务进行中推迟到最外层提交时刷新一次
+ *  @param  表格名
+ *  @retval 是否刷新成功
+ */
+bool EasySQLite::tableModelRefresh(const QString &tableName){
+    //WITHOUT ROWID表与不带条件的DELETE不触发update钩子 写接口在此补充递增写版本
+    tableVersionBump(tableName);
+
+    if(m_transactionDepth>0){
+        m_transactionTableName = tableName;
+        return true;
+    }
+    //内部刷新不计入操作轨迹
+    m_traceDepth++;
+    bool isSuccess = recordSelectTableAll(tableName);
+    m_traceDepth--;
+    return isSuccess;
+}
+
+/*
+ *  @brief  开启事务 已在事务中时建立保存点
+ *          事务进行中其余接口共用同一连接 不再各自打开关闭数据库 也不刷新TableModel
+ *          分片表位于独立连接 不参与事务
+ *  @param  无
+ *  @retval 是否开启成功
+ */
+bool EasySQLite::transactionBegin(){
+    TraceScope trace(this,TraceMethod::TransactionBegin,QString());
+
+    if(m_isSnapshot){
+        m_errorInfo = "[EasySQLite/Error]事务开启报错: 只读快照进行中";
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]事务开启报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    QSqlQuery query;
+    //最外层立即取得写锁 避免两个读事务同时升级写锁时互相等待
+    QString sql = m_transactionDepth==0?QString("BEGIN IMMEDIATE"):QString("SAVEPOINT easysqlite_sp_%1").arg(m_transactionDepth);
+    if(!busyRetryExec(query,sql,true)){
+        m_errorInfo = "[EasySQLite/Error]事务开启报错: " + query.lastError().text();
+        if(m_transactionDepth==0){
+            databaseClose();
+        }
+        return false;
+    }
+
+    m_transactionDepth++;
+    return true;
+}
+
+/*
+ *  @brief  提交最内层事务 保存点仅释放 最外层提交后刷新TableModel并关闭数据库
+ *  @param  无
+ *  @retval 是否提交成功
+ */
+bool EasySQLite::transactionCommit(){
+    TraceScope trace(this,TraceMethod::TransactionCommit,QString());
+
+    if(m_isSnapshot){
+        m_errorInfo = "[EasySQLite/Error]事务提交报错: 只读快照请用snapshotEnd释放";
+        return false;
+    }
+    if(m_transactionDepth==0){
+        m_errorInfo = "[EasySQLite/Error]事务提交报错: 当前没有进行中的事务";
+        return false;
+    }
+
+    QSqlQuery query;
+    //内层 释放保存点
+    if(m_transactionDepth>1){
+        if(!query.exec(QString("RELEASE SAVEPOINT easysqlite_sp_%1").arg(m_transactionDepth-1))){
+            m_errorInfo = "[EasySQLite/Error]事务提交报错: " + query.lastError().text();
+            return false;
+        }
+        m_transactionDepth--;
+        return true;
+    }
+
+    //最外层 提交并计时
+    QElapsedTimer timer;
+    timer.start();
+    if(!busyRetryExec(query,"COMMIT",true)){
+        //提交失败 事务仍在进行 由调用方决定重试或回滚
+        m_errorInfo = "[EasySQLite/Error]事务提交报错: " + query.lastError().text();
+        return false;
+    }
+    qint64 duration = timer.nsecsElapsed()/1000;
+    m_transactionStats.commitNum++;
+    m_transactionStats.lastCommitDuration = duration;
+    m_transactionStats.totalCommitDuration += duration;
+    m_transactionStats.maxCommitDuration = qMax(m_transactionStats.maxCommitDuration,duration);
+
+    m_transactionDepth = 0;
+    QString tableName = m_transactionTableName;
+    m_transactionTableName.clear();
+    //内部刷新不计入操作轨迹
+    m_traceDepth++;
+    bool isRefreshed = tableName.isEmpty()||recordSelectTableAll(tableName);
+    m_traceDepth--;
+    if(!isRefreshed){
+        m_errorInfo = "[EasySQLite/Error]事务提交报错: 查询TableModel错误";
+        databaseClose();
+        return false;
+    }
+
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  回滚最内层事务 保存点回滚后释放 最外层回滚后关闭数据库
+ *  @param  无
+ *  @retval 是否回滚成功
+ */
+bool EasySQLite::transactionRollback(){
+    TraceScope trace(this,TraceMethod::TransactionRollback,QString());
+
+    if(m_transactionDepth==0){
+        m_errorInfo = "[EasySQLite/Error]事务回滚报错: 当前没有进行中的事务";
+        return false;
+    }
+
+    QSqlQuery query;
+    //内层 回滚到保存点并释放
+    if(m_transactionDepth>1){
+        QString savepointName = QString("easysqlite_sp_%1").arg(m_transactionDepth-1);
+        if(!query.exec(QString("ROLLBACK TO SAVEPOINT %1").arg(savepointName))
+            ||!query.exec(QString("RELEASE SAVEPOINT %1").arg(savepointName))){
+            m_errorInfo = "[EasySQLite/Error]事务回滚报错: " + query.lastError().text();
+            return false;
+        }
+        //回滚到保存点不触发rollback钩子
+        writeEpochBump();
+        m_transactionDepth--;
+        partitionListReload();
+        return true;
+    }
+
+    //最外层 写操作均未刷新TableModel 回滚后无需刷新
+    bool isSuccess = query.exec("ROLLBACK");
+    if(!isSuccess){
+        m_errorInfo = "[EasySQLite/Error]事务回滚报错: " + query.lastError().text();
+    }
+    partitionListReload();
+    if(m_isSnapshot){
+        query.exec("PRAGMA query_only = OFF");
+    }
+    m_transactionStats.rollbackNum++;
+    m_transactionDepth = 0;
+    m_isSnapshot = false;
+    m_transactionTableName.clear();
+    databaseClose();
+    return isSuccess;
+}
+
+/*
+ *  @brief  获取当前事务嵌套层数
+ *  @param  无
+ *  @retval 0表示不在事务中
+ */
+int EasySQLite::transactionDepth(){
+    return m_transactionDepth;
+}
+
+/*
+ *  @brief  获取事务提交统计
+ *  @param  无
+ *  @retval 提交/回滚次数与提交耗时(微秒)
+ */
+ESTransactionStats EasySQLite::transactionStats(){
+    return m_transactionStats;
+}
+
+EasySQLiteTransaction::EasySQLiteTransaction(EasySQLite *easySQLite)
+    :m_easySQLite(easySQLite){
+    m_isActive = m_easySQLite->transactionBegin();
+}
+
+EasySQLiteTransaction::~EasySQLiteTransaction(){
+    if(m_isActive){
+        m_easySQLite->transactionRollback();
+    }
+}
+
+/*
+ *  @brief  事务是否开启成功且尚未结束
+ *  @param  无
+ *  @retval 是否活跃
+ */
+bool EasySQLiteTransaction::isActive(){
+    return m_isActive;
+}
+
+/*
+ *  @brief  提交本守卫开启的事务或保存点
+ *  @param  无
+ *  @retval 是否提交成功 失败时守卫仍活跃 析构时回滚
+ */
+bool EasySQLiteTransaction::commit(){
+    if(!m_isActive){
+        return false;
+    }
+    m_isActive = !m_easySQLite->transactionCommit();
+    return !m_isActive;
+}
+
+/*
+ *  @brief  回滚本守卫开启的事务或保存点
+ *  @param  无
+ *  @retval 是否回滚成功
+ */
+bool EasySQLiteTransaction::rollback(){
+    if(!m_isActive){
+        return false;
+    }
+    m_isActive = false;
+    return m_easySQLite->transactionRollback();
+}
+
+/*
+ *  @brief  在同一事务中按顺序执行多条混合写操作
+ *          执行前按缓存的表结构校验全部操作 同一形态的语句只准备一次
+ *          任一操作失败则整批回滚 已在事务中时作为保存点加入
+ *  @param  写操作列表
+ *  @param  逐条结果列表(输出) 与写操作一一对应
+ *  @retval 是否整批执行成功
+ */
+bool EasySQLite::writeBatch(const QList<ESWrite> &writeList, QList<ESWriteResult> &resultList){
+    TraceScope trace(this,TraceMethod::WriteBatch,QString(),writeList);
+
+    resultList = QList<ESWriteResult>(writeList.size());
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("批量写")){
+        return false;
+    }
+    if(writeList.isEmpty()){
+        return true;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]批量写报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //校验全部操作并生成SQL语句
+    QStringList tableNameList = m_database.tables();
+    QStringList sqlList;
+    sqlList.reserve(writeList.size());
+    QList<QStringList> fieldNameListList(writeList.size());
+    bool isValid = true;
+    for (int var = 0; var < writeList.size(); ++var) {
+        const ESWrite& write = writeList.at(var);
+        QString& errorInfo = resultList[var].errorInfo;
+        TableSchema schema;
+        if(m_shardNumHash.contains(write.tableName)){
+            errorInfo = "[EasySQLite/Error]批量写报错: 分片表不支持批量写";
+        }else if(!tableNameList.contains(write.tableName)||!tableSchema(write.tableName,schema)){
+            errorInfo = "[EasySQLite/Error]批量写报错: 表格不存在";
+        }else if((write.kind==ESWrite::Kind::Insert||write.kind==ESWrite::Kind::Upsert)
+                   &&write.values.size()!=schema.fieldNameList.size()){
+            errorInfo = "[EasySQLite/Error]批量写报错: 数据个数与字段数不一致";
+        }else if(write.kind==ESWrite::Kind::Update&&(write.fieldNameList.isEmpty()||write.values.size()!=write.fieldNameList.size())){
+            errorInfo = "[EasySQLite/Error]批量写报错: 字段名与数据个数不一致";
+        }else if(write.kind!=ESWrite::Kind::Insert&&schema.primarykeyName.isEmpty()){
+            errorInfo = "[EasySQLite/Error]批量写报错: 表格没有主键";
+        }else if(write.kind==ESWrite::Kind::Update){
+            for (int fieldIndex = 0; fieldIndex < write.fieldNameList.size(); ++fieldIndex) {
+                if(!schema.fieldNameList.contains(write.fieldNameList.at(fieldIndex))){
+                    errorInfo = "[EasySQLite/Error]批量写报错: 字段不存在 " + write.fieldNameList.at(fieldIndex);
+                    break;
+                }
+            }
+        }
+        if(!errorInfo.isEmpty()){
+            isValid = false;
+            sqlList.append(QString());
+            continue;
+        }
+
+        fieldNameListList[var] = schema.fieldNameList;
+        QStringList placeholderList;
+        QStringList setList;
+        switch (write.kind) {
+        case ESWrite::Kind::Insert:
+        case ESWrite::Kind::Upsert:
+            for (int fieldIndex = 0; fieldIndex < schema.fieldNameList.size(); ++fieldIndex) {
+                placeholderList.append("?");
+                if(schema.fieldNameList.at(fieldIndex)!=schema.primarykeyName){
+                    setList.append(QString("%1 = excluded.%1").arg(schema.fieldNameList.at(fieldIndex)));
+                }
+            }
+            if(write.kind==ESWrite::Kind::Insert){
+                sqlList.append(QString("INSERT INTO %1 VALUES(%2)").arg(write.tableName,placeholderList.join(",")));
+            }else if(setList.isEmpty()){
+                //只有主键列 冲突时无需更新
+                sqlList.append(QString("INSERT OR IGNORE INTO %1 VALUES(%2)").arg(write.tableName,placeholderList.join(",")));
+            }else{
+                sqlList.append(QString("INSERT INTO %1 VALUES(%2) ON CONFLICT(%3) DO UPDATE SET %4")
+                                   .arg(write.tableName,placeholderList.join(","),schema.primarykeyName,setList.join(",")));
+            }
+            break;
+        case ESWrite::Kind::Update:
+            for (int fieldIndex = 0; fieldIndex < write.fieldNameList.size(); ++fieldIndex) {
+                setList.append(write.fieldNameList.at(fieldIndex) + " = ?");
+            }
+            sqlList.append(QString("UPDATE %1 SET %2 WHERE %3 = ?").arg(write.tableName,setList.join(","),schema.primarykeyName));
+            break;
+        case ESWrite::Kind::Delete:
+            sqlList.append(QString("DELETE FROM %1 WHERE %2 = ?").arg(write.tableName,schema.primarykeyName));
+            break;
+        }
+    }
+    if(!isValid){
+        m_errorInfo = "[EasySQLite/Error]批量写报错: 存在无效操作 整批未执行";
+        databaseClose();
+        return false;
+    }
+
+    //校验通过 在同一事务中执行
+    if(!transactionBegin()){
+        m_errorInfo = "[EasySQLite/Error]批量写报错: 事务开启失败";
+        databaseClose();
+        return false;
+    }
+
+    QHash<QString,QSqlQuery> queryHash;
+    for (int var = 0; var < writeList.size(); ++var) {
+        const ESWrite& write = writeList.at(var);
+        ESWriteResult& result = resultList[var];
+
+        //同一形态的语句复用已准备的查询
+        if(!queryHash.contains(sqlList.at(var))){
+            QSqlQuery query;
+            if(!query.prepare(sqlList.at(var))){
+                result.errorInfo = "[EasySQLite/Error]批量写报错: SQL语句准备失败" + query.lastError().text();
+                m_errorInfo = result.errorInfo;
+                transactionRollback();
+                return false;
+            }
+            queryHash.insert(sqlList.at(var),query);
+        }
+        QSqlQuery& query = queryHash[sqlList.at(var)];
+        const QStringList& fieldNameList = (write.kind==ESWrite::Kind::Update)?write.fieldNameList:fieldNameListList.at(var);
+        for (int valueIndex = 0; valueIndex < write.values.size(); ++valueIndex) {
+            //压缩字段绑定压缩后的BLOB
+            QByteArray compressed;
+            if(valueIndex<fieldNameList.size()&&compressValue(write.tableName,fieldNameList.at(valueIndex),write.values.at(valueIndex),compressed)){
+                query.bindValue(valueIndex,compressed);
+            }else{
+                query.bindValue(valueIndex,write.values.at(valueIndex));
+            }
+        }
+        if(write.kind==ESWrite::Kind::Update){
+            query.bindValue(write.values.size(),write.primarykeyValue);
+        }else if(write.kind==ESWrite::Kind::Delete){
+            query.bindValue(0,write.primarykeyValue);
+        }
+
+        if(!queryExec(query)){
+            //任一操作失败 整批回滚 之前成功的结果随之作废
+            result.errorInfo = "[EasySQLite/Error]批量写报错: 执行SQL语句错误" + query.lastError().text();
+            m_errorInfo = result.errorInfo;
+            for (int doneIndex = 0; doneIndex < var; ++doneIndex) {
+                resultList[doneIndex].isSuccess = false;
+                resultList[doneIndex].errorInfo = "[EasySQLite/Error]批量写报错: 整批已回滚";
+            }
+            transactionRollback();
+            return false;
+        }
+        result.isSuccess = true;
+        result.affectedNum = query.numRowsAffected();
+        tableModelRefresh(write.tableName);
+    }
+
+    if(!transactionCommit()){
+        for (int var = 0; var < resultList.size(); ++var) {
+            resultList[var].isSuccess = false;
+            resultList[var].errorInfo = m_errorInfo;
+        }
+        transactionRollback();
+        return false;
+    }
+    return true;
+}
+
+/*
+ *  @brief  定时器触发的维护时间片 数据库空闲时轮流执行一项维护任务
+ *  @param  无
+ *  @retval 无
+ */
+void EasySQLite::maintenanceSlice(){
+    //事务或增量备份进行中 或最近有SQL执行 跳过本轮
+    if(m_transactionDepth>0||m_backup!=nullptr
+        ||QDateTime::currentMSecsSinceEpoch()-m_lastActivityTime<m_maintenanceIdle){
+        return;
+    }
+
+    if(!m_database.isOpen()&&!databaseOpen()){
+        qDebug().noquote()<<"[EasySQLite/Error]后台维护报错: 数据库打开失败";
+        return;
+    }
+
+    MaintenanceTask task = m_maintenanceTask;
+    switch (task) {
+    case MaintenanceTask::Checkpoint:
+        m_maintenanceTask = MaintenanceTask::Vacuum;
+        break;
+    case MaintenanceTask::Vacuum:
+        m_maintenanceTask = MaintenanceTask::Optimize;
+        break;
+    case MaintenanceTask::Optimize:
+        m_maintenanceTask = MaintenanceTask::Checkpoint;
+        break;
+    }
+    if(!maintenanceTaskRun(task,m_maintenanceSlice)){
+        qDebug().noquote()<<m_errorInfo;
+    }
+
+    databaseClose();
+}
+
+/*
+ *  @brief  执行一项维护任务 默认数据库已打开
+ *  @param  维护任务
+ *  @param  时间片上限(毫秒) 仅增量清理按页分批受其约束 小于0表示不限
+ *  @retval 是否执行成功
+ */
+bool EasySQLite::maintenanceTaskRun(MaintenanceTask task, qint64 sliceMsec){
+    QSqlQuery query;
+    switch (task) {
+    case MaintenanceTask::Checkpoint:{
+        //非WAL模式无需检查点
+        QString walPath = walFilePath();
+        if(walPath.isEmpty()||!QFileInfo::exists(walPath)){
+            return true;
+        }
+        //WAL文件过大时截断 否则被动检查点 不等待读写连接
+        QString mode = QFileInfo(walPath).size()>m_walTruncateSize?"TRUNCATE":"PASSIVE";
+        if(!query.exec(QString("PRAGMA wal_checkpoint(%1)").arg(mode))){
+            m_errorInfo = "[EasySQLite/Error]后台维护报错: WAL检查点失败" + query.lastError().text();
+            return false;
+        }
+        m_maintenanceStats.lastCheckpointTime = QDateTime::currentDateTime();
+        return true;
+    }
+    case MaintenanceTask::Vacuum:{
+        if(!query.exec("PRAGMA auto_vacuum")||!query.next()||query.value(0).toInt()!=2){
+            //未启用INCREMENTAL 跳过
+            return true;
+        }
+        //每批回收固定页数 直到没有空闲页或用完时间片
+        const qint64 stepPageNum = 256;
+        QElapsedTimer timer;
+        timer.start();
+        while(sliceMsec<0||timer.elapsed()<sliceMsec){
+            if(!query.exec("PRAGMA freelist_count")||!query.next()){
+                m_errorInfo = "[EasySQLite/Error]后台维护报错: 查询空闲页数失败" + query.lastError().text();
+                return false;
+            }
+            qint64 freePageNum = query.value(0).toLongLong();
+            if(freePageNum==0){
+                break;
+            }
+            qint64 pageNum = qMin(freePageNum,stepPageNum);
+            if(!query.exec(QString("PRAGMA incremental_vacuum(%1)").arg(pageNum))){
+                m_errorInfo = "[EasySQLite/Error]后台维护报错: 增量清理失败" + query.lastError().text();
+                return false;
+            }
+            //逐行取完才会真正执行完所有步骤
+            while(query.next()){
+            }
+            m_maintenanceStats.vacuumPageNum += pageNum;
+        }
+        m_maintenanceStats.lastVacuumTime = QDateTime::currentDateTime();
+        return true;
+    }
+    case MaintenanceTask::Optimize:
+        //限制每个索引的采样行数 使ANALYZE耗时有界
+        if(!query.exec("PRAGMA analysis_limit = 400")||!query.exec("PRAGMA optimize")){
+            m_errorInfo = "[EasySQLite/Error]后台维护报错: PRAGMA optimize失败" + query.lastError().text();
+            return false;
+        }
+        m_maintenanceStats.lastOptimizeTime = QDateTime::currentDateTime();
+        return true;
+    }
+    return true;
+}
+
+/*
+ *  @brief  获取WAL文件路径
+ *  @param  无
+ *  @retval 路径 内存模式返回空
+ */
+QString EasySQLite::walFilePath(){
+    if(m_memoryMode){
+        return QString();
+    }
+    return m_database.databaseName() + "-wal";
+}
+
+/*
+ *  @brief  立即依次执行全部维护任务 不检查空闲 不受时间片限制
+ *  @param  无
+ *  @retval 是否全部执行成功
+ */
+bool EasySQLite::maintenanceRun(){
+    if(m_transactionDepth>0){
+        m_errorInfo = "[EasySQLite/Error]后台维护报错: 事务进行中";
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]后台维护报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    bool ret = maintenanceTaskRun(MaintenanceTask::Checkpoint,-1)
+               &&maintenanceTaskRun(MaintenanceTask::Vacuum,-1)
+               &&maintenanceTaskRun(MaintenanceTask::Optimize,-1);
+    databaseClose();
+    return ret;
+}
+
+/*
+ *  @brief  获取维护状态 空闲页数与WAL大小为实时查询
+ *  @param  无
+ *  @retval 维护状态 查询失败时空闲页数与页大小为-1
+ */
+ESMaintenanceStats EasySQLite::maintenanceStats(){
+    ESMaintenanceStats stats = m_maintenanceStats;
+
+    QString walPath = walFilePath();
+    stats.walSize = walPath.isEmpty()?0:QFileInfo(walPath).size();
+
+    if(!m_database.isOpen()&&!databaseOpen()){
+        return stats;
+    }
+    QSqlQuery query;
+    if(query.exec("PRAGMA freelist_count")&&query.next()){
+        stats.freePageNum = query.value(0).toLongLong();
+    }
+    if(query.exec("PRAGMA page_size")&&query.next()){
+        stats.pageSize = query.value(0).toLongLong();
+    }
+    query.finish();
+    databaseClose();
+    return stats;
+}
+
+/*
+ *  @brief  初始化分区表 登记已有分区并建立当前分区 默认数据库已打开
+ *  @param  逻辑表名
+ *  @param  表格定义
+ *  @param  时间字段名 存放毫秒时间戳
+ *  @param  分区周期(秒)
+ *  @param  保留分区个数 0表示全部保留
+ *  @retval 是否初始化成功
+ */
+bool EasySQLite::partitionTableInit(const QString &tableName, const QString &definition, const QString &timeFieldName,
+                                    int periodSecs, int retentionNum){
+    if(periodSecs<=0||retentionNum<0){
+        m_errorInfo = "[EasySQLite/Error]分区表初始化报错: 分区周期或保留个数错误";
+        return false;
+    }
+
+    Partition partition;
+    partition.definition = definition;
+    partition.timeFieldName = timeFieldName;
+    partition.periodMsec = static_cast<qint64>(periodSecs)*1000;
+    partition.retentionNum = retentionNum;
+
+    //登记已有分区
+    m_partitionHash.insert(tableName,partition);
+    if(!partitionListLoad(tableName)){
+        m_partitionHash.remove(tableName);
+        return false;
+    }
+
+    //建立当前分区 并由其缓存字段名
+    qint64 currentNo = QDateTime::currentMSecsSinceEpoch()/partition.periodMsec;
+    Partition& cached = m_partitionHash[tableName];
+    if(!partitionEnsure(tableName,currentNo)||!fieldNameQuery(partitionName(tableName,currentNo),cached.fieldNameList)){
+        m_partitionHash.remove(tableName);
+        return false;
+    }
+    cached.timeFieldIndex = cached.fieldNameList.indexOf(timeFieldName);
+    if(cached.timeFieldIndex<0){
+        m_errorInfo = "[EasySQLite/Error]分区表初始化报错: 时间字段不存在";
+        m_partitionHash.remove(tableName);
+        return false;
+    }
+    return true;
+}
+
+/*
+ *  @brief  从sqlite_master重新读取分区列表 默认数据库已打开
+ *          分区的建立与删除可能随调用方事务回滚 回滚后以数据库中实际存在的分区为准
+ *  @param  逻辑表名
+ *  @retval 是否读取成功
+ */
+bool EasySQLite::partitionListLoad(const QString &tableName){
+    QSqlQuery query;
+    if(!query.exec(QString("SELECT name FROM sqlite_master WHERE type = 'table' AND name LIKE '%1\\_p%' ESCAPE '\\'").arg(tableName))){
+        m_errorInfo = "[EasySQLite/Error]分区列表读取报错: " + query.lastError().text();
+        return false;
+    }
+    QList<qint64>& partitionList = m_partitionHash[tableName].partitionList;
+    partitionList.clear();
+    QString prefix = tableName + "_p";
+    while(query.next()){
+        bool isNumber = false;
+        qint64 partitionNo = query.value(0).toString().mid(prefix.size()).toLongLong(&isNumber);
+        if(isNumber){
+            partitionList.append(partitionNo);
+        }
+    }
+    std::sort(partitionList.begin(),partitionList.end());
+    return true;
+}
+
+/*
+ *  @brief  获取分区的物理表名
+ *  @param  逻辑表名
+ *  @param  分区序号 即时间戳/周期
+ *  @retval 物理表名
+ */
+QString EasySQLite::partitionName(const QString &tableName, qint64 partitionNo){
+    return QString("%1_p%2").arg(tableName).arg(partitionNo);
+}
+
+/*
+ *  @brief  确保分区存在 新建分区后按保留个数整表删除过期分区 默认数据库已打开
+ *  @param  逻辑表名
+ *  @param  分区序号
+ *  @retval 是否成功
+ */
+bool EasySQLite::partitionEnsure(const QString &tableName, qint64 partitionNo){
+    Partition& partition = m_partitionHash[tableName];
+    if(partition.partitionList.contains(partitionNo)){
+        return true;
+    }
+
+    //早于保留范围的数据不再建分区
+    if(partition.retentionNum>0&&!partition.partitionList.isEmpty()
+        &&partitionNo<=partition.partitionList.last()-partition.retentionNum){
+        m_errorInfo = "[EasySQLite/Error]分区建立报错: 时间早于保留范围";
+        return false;
+    }
+
+    QSqlQuery query;
+    if(!queryExec(query,QString("CREATE TABLE IF NOT EXISTS %1(%2)").arg(partitionName(tableName,partitionNo),partition.definition))){
+        m_errorInfo = "[EasySQLite/Error]分区建立报错: " + query.lastError().text();
+        return false;
+    }
+    partition.partitionList.insert(std::lower_bound(partition.partitionList.begin(),partition.partitionList.end(),partitionNo),
+                                   partitionNo);
+
+    //整表删除超出保留个数的旧分区 代价与行数无关 当前时间所在分区与新建分区保留
+    qint64 currentNo = QDateTime::currentMSecsSinceEpoch()/partition.periodMsec;
+    for (int index = 0; partition.retentionNum>0&&partition.partitionList.size()>partition.retentionNum
+                        &&index<partition.partitionList.size(); ) {
+        qint64 oldNo = partition.partitionList.at(index);
+        if(oldNo==currentNo||oldNo==partitionNo){
+            index++;
+            continue;
+        }
+        QString name = partitionName(tableName,oldNo);
+        if(!queryExec(query,QString("DROP TABLE IF EXISTS %1").arg(name))){
+            m_errorInfo = "[EasySQLite/Error]分区删除报错: " + query.lastError().text();
+            return false;
+        }
+        partition.partitionList.removeAt(index);
+        qDebug().noquote()<<"[EasySQLite/Info]分区表: 删除过期分区"<<name;
+    }
+    return true;
+}
+
+/*
+ *  @brief  从条件字符串中提取时间字段的范围 只识别and连接的比较与between条件
+ *          含or/not等无法确定范围的条件时返回全范围
+ *  @param  时间字段名
+ *  @param  条件字符串
+ *  @param  下界(输出 含)
+ *  @param  上界(输出 含)
+ *  @retval 无
+ */
+void EasySQLite::partitionRange(const QString &timeFieldName, const QString &condition, qint64 &lower, qint64 &upper){
+    lower = std::numeric_limits<qint64>::min();
+    upper = std::numeric_limits<qint64>::max();
+    static const QRegularExpression unsafe("\\b(or|not)\\b",QRegularExpression::CaseInsensitiveOption);
+    if(condition.isEmpty()||condition.contains(unsafe)){
+        return;
+    }
+
+    QString field = QRegularExpression::escape(timeFieldName);
+    QRegularExpression compare(QString("\\b%1\\s*(>=|<=|>|<|=)\\s*(-?\\d+)").arg(field));
+    QRegularExpressionMatchIterator iterator = compare.globalMatch(condition);
+    while(iterator.hasNext()){
+        QRegularExpressionMatch match = iterator.next();
+        QString op = match.captured(1);
+        qint64 value = match.captured(2).toLongLong();
+        if(op==">="||op=="="){
+            lower = qMax(lower,value);
+        }
+        if(op==">"){
+            lower = qMax(lower,value+1);
+        }
+        if(op=="<="||op=="="){
+            upper = qMin(upper,value);
+        }
+        if(op=="<"){
+            upper = qMin(upper,value-1);
+        }
+    }
+
+    QRegularExpression between(QString("\\b%1\\s+between\\s+(-?\\d+)\\s+and\\s+(-?\\d+)").arg(field),
+                               QRegularExpression::CaseInsensitiveOption);
+    iterator = between.globalMatch(condition);
+    while(iterator.hasNext()){
+        QRegularExpressionMatch match = iterator.next();
+        lower = qMax(lower,match.captured(1).toLongLong());
+        upper = qMin(upper,match.captured(2).toLongLong());
+    }
+}
+
+/*
+ *  @brief  向分区表插入多行记录 按时间字段分组写入各分区 同一事务提交 不刷新TableModel
+ *  @param  逻辑表名
+ *  @param  插入数据参数列表
+ *  @retval 是否插入成功
+ */
+bool EasySQLite::partitionRecordInsert(const QString &tableName, const QList<QVariantList> &valuesList){
+    const Partition& partition = m_partitionHash[tableName];
+
+    //按分区分组
+    QMap<qint64,QList<QVariantList>> partitionValuesMap;
+    for (int var = 0; var < valuesList.size(); ++var) {
+        const QVariantList& values = valuesList.at(var);
+        if(values.size()!=partition.fieldNameList.size()){
+            m_errorInfo = "[EasySQLite/Error]分区表插入报错: 数据个数与字段数不一致";
+            return false;
+        }
+        bool isNumber = false;
+        qint64 time = values.at(partition.timeFieldIndex).toLongLong(&isNumber);
+        if(!isNumber){
+            m_errorInfo = "[EasySQLite/Error]分区表插入报错: 时间字段不是毫秒时间戳";
+            return false;
+        }
+        //向下取整 负时间戳同样落在正确的周期
+        qint64 partitionNo = time/partition.periodMsec - ((time%partition.periodMsec<0)?1:0);
+        partitionValuesMap[partitionNo].append(values);
+    }
+
+    if(!transactionBegin()){
+        m_errorInfo = "[EasySQLite/Error]分区表插入报错: 事务开启失败";
+        return false;
+    }
+    for (auto iterator = partitionValuesMap.cbegin(); iterator != partitionValuesMap.cend(); ++iterator) {
+        if(!partitionEnsure(tableName,iterator.key())){
+            QString errorInfo = m_errorInfo;
+            transactionRollback();
+            m_errorInfo = errorInfo;
+            return false;
+        }
+        const QList<QVariantList>& partitionValuesList = iterator.value();
+        QSqlQuery query;
+        QString sql = QString("INSERT INTO %1 VALUES").arg(partitionName(tableName,iterator.key()));
+        for (int var = 0; var < partitionValuesList.size(); ++var) {
+            sql += QString("(%1),").arg(compressedValues2SqlFormat(tableName,partitionValuesList.at(var)));
+        }
+        sql.removeLast();
+        if(!queryExec(query,sql)){
+            m_errorInfo = "[EasySQLite/Error]分区表插入报错: 执行SQL语句插入数据错误" + query.lastError().text();
+            QString errorInfo = m_errorInfo;
+            transactionRollback();
+            m_errorInfo = errorInfo;
+            return false;
+        }
+    }
+    if(!transactionCommit()){
+        transactionRollback();
+        return false;
+    }
+    return true;
+}
+
+/*
+ *  @brief  查询分区表 只合并与条件时间范围重叠的分区 结果赋值TableModel
+ *  @param  逻辑表名
+ *  @param  查询字段名列表
+ *  @param  条件字符串 为空表示全部
+ *  @param  排序字段名
+ *  @param  排序策略
+ *  @retval 是否查询成功
+ */
+bool EasySQLite::partitionRecordSelect(const QString &tableName, const QStringList &fieldNameList, const QString &condition,
+                                       const QString &sortFieldName, const SortPolicy &sortPolicy){
+    const Partition& partition = m_partitionHash[tableName];
+    for (int var = 0; var < fieldNameList.size(); ++var) {
+        if(!partition.fieldNameList.contains(fieldNameList.at(var))){
+            m_errorInfo = "[EasySQLite/Error]分区表查询报错: 查询字段名不存在";
+            return false;
+        }
+    }
+    if(!partition.fieldNameList.contains(sortFieldName)){
+        m_errorInfo = "[EasySQLite/Error]分区表查询报错: 排序字段名不存在";
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]分区表查询报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //筛选与时间范围重叠的分区 分区覆盖[序号*周期, (序号+1)*周期)
+    qint64 lower = 0;
+    qint64 upper = 0;
+    partitionRange(partition.timeFieldName,condition,lower,upper);
+    QString strCondition = condition.isEmpty()?QString():" WHERE "+condition;
+    QStringList selectList;
+    for (int var = 0; var < partition.partitionList.size(); ++var) {
+        qint64 partitionNo = partition.partitionList.at(var);
+        qint64 begin = partitionNo*partition.periodMsec;
+        qint64 end = begin+partition.periodMsec-1;
+        if(end<lower||begin>upper){
+            continue;
+        }
+        selectList.append(QString("SELECT * FROM %1%2").arg(partitionName(tableName,partitionNo),strCondition));
+    }
+    if(selectList.isEmpty()&&!partition.partitionList.isEmpty()){
+        //没有重叠分区 保持结果列一致
+        selectList.append(QString("SELECT * FROM %1 WHERE 0").arg(partitionName(tableName,partition.partitionList.last())));
+    }else if(selectList.isEmpty()){
+        //分区已全部删除(或随回滚撤销) 按缓存的字段名构造空结果
+        selectList.append(QString("SELECT NULL AS %1 WHERE 0").arg(partition.fieldNameList.join(",NULL AS ")));
+    }
+
+    QString policy = (sortPolicy==SortPolicy::ASC)?"ASC":"DESC";
+    QSqlQuery query;
+    if(!queryExec(query,QString("SELECT %1 FROM (%2) ORDER BY %3 %4")
+                           .arg(fieldNameList.join(","),selectList.join(" UNION ALL "),sortFieldName,policy))){
+        m_errorInfo = "[EasySQLite/Error]分区表查询报错: 执行SQL语句查询错误" + query.lastError().text();
+        return false;
+    }
+
+    //查询成功 赋值变量model
+    m_tableModel= tableModelCreate(tableName,query);
+
+    //查询成功 关闭数据库
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  判断是否为分区表
+ *  @param  表格名
+ *  @retval 是否为分区表
+ */
+bool EasySQLite::isPartitionedTable(const QString &tableName){
+    return m_partitionHash.contains(tableName);
+}
+
+/*
+ *  @brief  获取分区表现有的物理表名
+ *  @param  逻辑表名
+ *  @retval 物理表名列表 按时间先后排列
+ */
+QStringList EasySQLite::partitionNames(const QString &tableName){
+    QStringList ret;
+    const QList<qint64> partitionList = m_partitionHash.value(tableName).partitionList;
+    for (int var = 0; var < partitionList.size(); ++var) {
+        ret.append(partitionName(tableName,partitionList.at(var)));
+    }
+    return ret;
+}
+
+/*
+ *  @brief  整表删除完全早于指定时间的分区 当前分区保留
+ *  @param  逻辑表名
+ *  @param  毫秒时间戳
+ *  @retval 是否删除成功
+ */
+bool EasySQLite::partitionDrop(const QString &tableName, qint64 beforeMsec){
+    TraceScope trace(this,TraceMethod::PartitionDrop,tableName,beforeMsec);
+
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("分区删除")){
+        return false;
+    }
+
+    if(!m_partitionHash.contains(tableName)){
+        m_errorInfo = "[EasySQLite/Error]分区删除报错: 不是分区表";
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]分区删除报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //当前时间所在分区始终保留 存在未来时间的分区时也不会误删
+    Partition& partition = m_partitionHash[tableName];
+    qint64 currentNo = QDateTime::currentMSecsSinceEpoch()/partition.periodMsec;
+    QSqlQuery query;
+    for (int index = 0; index < partition.partitionList.size(); ) {
+        qint64 partitionNo = partition.partitionList.at(index);
+        if(partitionNo==currentNo||(partitionNo+1)*partition.periodMsec>beforeMsec){
+            index++;
+            continue;
+        }
+        if(!queryExec(query,QString("DROP TABLE IF EXISTS %1").arg(partitionName(tableName,partitionNo)))){
+            m_errorInfo = "[EasySQLite/Error]分区删除报错: " + query.lastError().text();
+            return false;
+        }
+        partition.partitionList.removeAt(index);
+    }
+
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  登记过期字段 并为时间字段建立索引 默认数据库已打开
+ *  @param  表格名
+ *  @param  时间字段名 存放毫秒时间戳
+ *  @param  存活时长(秒)
+ *  @retval 是否登记成功
+ */
+bool EasySQLite::ttlTableInit(const QString &tableName, const QString &timeFieldName, int ttlSecs){
+    TableSchema schema;
+    if(ttlSecs<=0||!m_database.tables().contains(tableName)||!tableSchema(tableName,schema)
+        ||!schema.fieldNameList.contains(timeFieldName)){
+        m_errorInfo = "[EasySQLite/Error]过期字段登记报错: 表格或时间字段不存在 或存活时长错误";
+        return false;
+    }
+
+    QSqlQuery query;
+    if(!query.exec(QString("CREATE INDEX IF NOT EXISTS %1_%2_ttl ON %1(%2)").arg(tableName,timeFieldName))){
+        m_errorInfo = "[EasySQLite/Error]过期字段登记报错: 索引创建失败" + query.lastError().text();
+        return false;
+    }
+
+    //按主键删除 兼容WITHOUT ROWID表 没有主键时用rowid
+    TTL ttl;
+    ttl.timeFieldName = timeFieldName;
+    ttl.keyName = schema.primarykeyName.isEmpty()?QString("rowid"):schema.primarykeyName;
+    ttl.ttlMsec = static_cast<qint64>(ttlSecs)*1000;
+    m_ttlHash.insert(tableName,ttl);
+    return true;
+}
+
+/*
+ *  @brief  在单独事务中删除一批过期行 默认数据库已打开
+ *  @param  表格名
+ *  @retval 删除的行数 失败返回-1
+ */
+int EasySQLite::ttlPurgeBatch(const QString &tableName){
+    TTL& ttl = m_ttlHash[tableName];
+    QElapsedTimer timer;
+    timer.start();
+
+    if(!transactionBegin()){
+        return -1;
+    }
+    QSqlQuery query;
+    query.prepare(QString("DELETE FROM %1 WHERE %2 IN (SELECT %2 FROM %1 WHERE %3 < ? LIMIT %4)")
+                      .arg(tableName,ttl.keyName,ttl.timeFieldName).arg(m_ttlPurgeBatch));
+    query.addBindValue(QDateTime::currentMSecsSinceEpoch()-ttl.ttlMsec);
+    if(!queryExec(query)){
+        m_errorInfo = "[EasySQLite/Error]过期清理报错: " + query.lastError().text();
+        QString errorInfo = m_errorInfo;
+        transactionRollback();
+        m_errorInfo = errorInfo;
+        return -1;
+    }
+    int rowNum = query.numRowsAffected();
+    query.finish();
+    if(!transactionCommit()){
+        transactionRollback();
+        return -1;
+    }
+
+    qint64 duration = timer.nsecsElapsed()/1000;
+    ttl.stats.purgeNum += rowNum;
+    ttl.stats.batchNum++;
+    ttl.stats.totalDuration += duration;
+    ttl.stats.lastBatchNum = rowNum;
+    ttl.stats.lastBatchDuration = duration;
+    ttl.stats.lastPurgeTime = QDateTime::currentDateTime();
+    return rowNum;
+}
+
+/*
+ *  @brief  定时器触发的过期清理 每个表删除一批 仍有剩余时下一轮事件循环继续
+ *          批与批之间交还事件循环 写操作不会被长时间阻塞
+ *  @param  无
+ *  @retval 无
+ */
+void EasySQLite::ttlPurgeSlice(){
+    //调用方事务进行中 清理会并入其事务 本轮跳过
+    if(m_transactionDepth>0){
+        m_isTTLPurging = false;
+        return;
+    }
+
+    //后台清理不计入操作轨迹
+    bool isRemaining = false;
+    m_traceDepth++;
+    for (auto iterator = m_ttlHash.cbegin(); iterator != m_ttlHash.cend(); ++iterator) {
+        int rowNum = ttlPurgeBatch(iterator.key());
+        if(rowNum<0){
+            qDebug().noquote()<<m_errorInfo;
+            continue;
+        }
+        if(rowNum>=m_ttlPurgeBatch){
+            isRemaining = true;
+        }
+    }
+    m_traceDepth--;
+
+    m_isTTLPurging = isRemaining;
+    if(isRemaining){
+        QTimer::singleShot(0,this,[this](){ttlPurgeSlice();});
+    }
+}
+
+/*
+ *  @brief  获取过期清理统计
+ *  @param  表格名
+ *  @retval 清理行数/批数/耗时 未登记的表格全部为0
+ */
+ESTTLStats EasySQLite::ttlStats(const QString &tableName){
+    return m_ttlHash.value(tableName).stats;
+}
+
+/*
+ *  @brief  原子地对字段做自增/追加 单条UPDATE ... RETURNING完成读改写 多行在同一事务中复用同一预编译语句
+ *  @param  报错标题
+ *  @param  表格名
+ *  @param  字段名
+ *  @param  新值表达式 %1为字段名 ?为操作数
+ *  @param  主键值与操作数列表
+ *  @param  更新后的新值列表(输出)
+ *  @retval 是否全部更新成功 任一主键值不存在则整体回滚
+ */
+bool EasySQLite::fieldModify(const QString &title, const QString &tableName, const QString &fieldName, const QString &expression,
+                             const QList<QPair<QVariant,QVariant>> &primarykeyOperandList, QVariantList &newValueList){
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected(title)){
+        return false;
+    }
+    if(m_shardNumHash.contains(tableName)||m_partitionHash.contains(tableName)){
+        m_errorInfo = QString("[EasySQLite/Error]%1报错: 分片表与分区表不支持").arg(title);
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = QString("[EasySQLite/Error]%1报错: 数据库打开失败").arg(title);
+            return false;
+        }
+    }
+
+    //用缓存的表结构校验 不做全表扫描
+    TableSchema schema;
+    if(!m_database.tables().contains(tableName)||!tableSchema(tableName,schema)){
+        m_errorInfo = QString("[EasySQLite/Error]%1报错: 表格不存在").arg(title);
+        return false;
+    }
+    if(!schema.fieldNameList.contains(fieldName)||schema.primarykeyName.isEmpty()||fieldName==schema.primarykeyName){
+        m_errorInfo = QString("[EasySQLite/Error]%1报错: 字段名不存在或表格没有主键").arg(title);
+        return false;
+    }
+    //压缩字段存放的是压缩后的BLOB 在SQL中运算会破坏数据
+    if(isCompressedField(tableName,fieldName)){
+        m_errorInfo = QString("[EasySQLite/Error]%1报错: 压缩字段不支持").arg(title);
+        return false;
+    }
+
+    if(!transactionBegin()){
+        m_errorInfo = QString("[EasySQLite/Error]%1报错: 事务开启失败").arg(title);
+        return false;
+    }
+    QSqlQuery query;
+    if(!query.prepare(QString("UPDATE %1 SET %2 = %3 WHERE %4 = ? RETURNING %2")
+                           .arg(tableName,fieldName,expression.arg(fieldName),schema.primarykeyName))){
+        m_errorInfo = QString("[EasySQLite/Error]%1报错: SQL语句准备失败").arg(title) + query.lastError().text();
+        QString errorInfo = m_errorInfo;
+        transactionRollback();
+        m_errorInfo = errorInfo;
+        return false;
+    }
+
+    newValueList.clear();
+    newValueList.reserve(primarykeyOperandList.size());
+    for (int var = 0; var < primarykeyOperandList.size(); ++var) {
+        query.bindValue(0,primarykeyOperandList.at(var).second);
+        query.bindValue(1,primarykeyOperandList.at(var).first);
+        if(!queryExec(query)||!query.next()){
+            //执行失败或没有返回行 即主键值不存在
+            m_errorInfo = QString("[EasySQLite/Error]%1报错: ").arg(title)
+                          + (query.lastError().isValid()?query.lastError().text():QString("主键值不存在"));
+            QString errorInfo = m_errorInfo;
+            query.finish();
+            transactionRollback();
+            m_errorInfo = errorInfo;
+            return false;
+        }
+        newValueList.append(query.value(0));
+        query.finish();
+    }
+
+    if(!transactionCommit()){
+        transactionRollback();
+        return false;
+    }
+    tableVersionBump(tableName);
+    return true;
+}
+
+/*
+ *  @brief  字段自增 字段为NULL时视为0 不刷新TableModel
+ *  @param  表格名
+ *  @param  主键值
+ *  @param  字段名
+ *  @param  增量 可为负数
+ *  @param  自增后的新值(输出)
+ *  @retval 是否自增成功
+ */
+bool EasySQLite::fieldIncrement(const QString &tableName, const QVariant &primarykeyValue, const QString &fieldName,
+                                const QVariant &delta, QVariant &newValue){
+    TraceScope trace(this,TraceMethod::FieldIncrement,tableName,primarykeyValue,fieldName,delta);
+
+    QVariantList newValueList;
+    if(!fieldModify("字段自增",tableName,fieldName,"coalesce(%1,0) + ?",{qMakePair(primarykeyValue,delta)},newValueList)){
+        return false;
+    }
+    newValue = newValueList.first();
+    return true;
+}
+
+/*
+ *  @brief  字段末尾追加文本 字段为NULL时视为空字符串 不刷新TableModel
+ *  @param  表格名
+ *  @param  主键值
+ *  @param  字段名
+ *  @param  追加内容
+ *  @param  追加后的新值(输出)
+ *  @retval 是否追加成功
+ */
+bool EasySQLite::fieldAppend(const QString &tableName, const QVariant &primarykeyValue, const QString &fieldName,
+                             const QVariant &suffix, QVariant &newValue){
+    TraceScope trace(this,TraceMethod::FieldAppend,tableName,primarykeyValue,fieldName,suffix);
+
+    QVariantList newValueList;
+    if(!fieldModify("字段追加",tableName,fieldName,"coalesce(%1,'') || ?",{qMakePair(primarykeyValue,suffix)},newValueList)){
+        return false;
+    }
+    newValue = newValueList.first();
+    return true;
+}
+
+/*
+ *  @brief  批量字段自增 全部在同一事务中执行 不刷新TableModel
+ *  @param  表格名
+ *  @param  字段名
+ *  @param  主键值与增量列表
+ *  @param  自增后的新值列表(输出) 与输入一一对应
+ *  @retval 是否全部自增成功 任一主键值不存在则整体回滚
+ */
+bool EasySQLite::fieldsIncrement(const QString &tableName, const QString &fieldName,
+                                 const QList<QPair<QVariant,QVariant>> &primarykeyDeltaList, QVariantList &newValueList){
+    TraceScope trace(this,TraceMethod::FieldsIncrement,tableName,fieldName,primarykeyDeltaList);
+
+    return fieldModify("批量字段自增",tableName,fieldName,"coalesce(%1,0) + ?",primarykeyDeltaList,newValueList);
+}
+
+/*
+ *  @brief  开启只读快照 在WAL连接上开启延迟读事务并立即建立快照
+ *          快照期间recordSelect/value等读接口共用同一连接 读到的是同一时刻的数据 不阻塞其他连接写入
+ *          快照会阻止检查点回收其后的WAL帧 应尽快释放
+ *          数据库不是WAL模式时切换为WAL 该设置写入数据库文件并永久保留 之后所有连接都以WAL模式打开
+ *          需要保持原日志模式(如旧版SQLite或网络文件系统访问该文件)时不要使用快照
+ *  @param  无
+ *  @retval 是否开启成功
+ */
+bool EasySQLite::snapshotBegin(){
+    TraceScope trace(this,TraceMethod::SnapshotBegin,QString());
+
+    if(m_transactionDepth>0){
+        m_errorInfo = "[EasySQLite/Error]只读快照开启报错: 事务或快照进行中";
+        return false;
+    }
+    if(m_memoryMode){
+        m_errorInfo = "[EasySQLite/Error]只读快照开启报错: 内存模式不支持WAL";
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]只读快照开启报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //非WAL模式下读事务会阻塞写入 先切换为WAL
+    QSqlQuery query;
+    if(!query.exec("PRAGMA journal_mode")||!query.next()
+        ||(query.value(0).toString().compare("wal",Qt::CaseInsensitive)!=0
+            &&(!query.exec("PRAGMA journal_mode = WAL")||!query.next()
+                ||query.value(0).toString().compare("wal",Qt::CaseInsensitive)!=0))){
+        m_errorInfo = "[EasySQLite/Error]只读快照开启报错: 切换WAL模式失败" + query.lastError().text();
+        databaseClose();
+        return false;
+    }
+    query.finish();
+
+    //延迟事务要到第一次读取才建立快照 立即读一次固定快照时刻
+    //快照期间禁止写入 写操作直接报错 不会升级为写事务
+    if(!query.exec("BEGIN DEFERRED")||!query.exec("SELECT count(*) FROM sqlite_master")
+        ||!query.exec("PRAGMA query_only = ON")){
+        m_errorInfo = "[EasySQLite/Error]只读快照开启报错: " + query.lastError().text();
+        query.exec("ROLLBACK");
+        query.exec("PRAGMA query_only = OFF");
+        databaseClose();
+        return false;
+    }
+    query.finish();
+
+    m_transactionDepth = 1;
+    m_isSnapshot = true;
+    m_snapshotTimer.start();
+    return true;
+}
+
+/*
+ *  @brief  释放只读快照 超过阈值的快照计入长快照并打印
+ *  @param  无
+ *  @retval 是否释放成功
+ */
+bool EasySQLite::snapshotEnd(){
+    TraceScope trace(this,TraceMethod::SnapshotEnd,QString());
+
+    if(!m_isSnapshot){
+        m_errorInfo = "[EasySQLite/Error]只读快照释放报错: 当前没有进行中的快照";
+        return false;
+    }
+
+    //快照期间只有读操作 提交与回滚等价
+    QSqlQuery query;
+    bool isSuccess = query.exec("ROLLBACK")&&query.exec("PRAGMA query_only = OFF");
+    if(!isSuccess){
+        m_errorInfo = "[EasySQLite/Error]只读快照释放报错: " + query.lastError().text();
+    }
+
+    qint64 duration = m_snapshotTimer.elapsed();
+    m_snapshotStats.snapshotNum++;
+    m_snapshotStats.lastDuration = duration;
+    m_snapshotStats.maxDuration = qMax(m_snapshotStats.maxDuration,duration);
+    if(duration>=m_snapshotWarnThreshold){
+        m_snapshotStats.longSnapshotNum++;
+        qDebug().noquote()<<QString("[EasySQLite/Info]只读快照: 持续%1毫秒 期间WAL无法完整检查点").arg(duration);
+    }
+
+    m_transactionDepth = 0;
+    m_isSnapshot = false;
+    m_transactionTableName.clear();
+    databaseClose();
+    return isSuccess;
+}
+
+/*
+ *  @brief  是否处于只读快照中
+ *  @param  无
+ *  @retval 是否处于快照中
+ */
+bool EasySQLite::isInSnapshot(){
+    return m_isSnapshot;
+}
+
+/*
+ *  @brief  设置长快照阈值
+ *  @param  阈值(毫秒)
+ *  @retval 无
+ */
+void EasySQLite::setSnapshotWarnThreshold(int msec){
+    m_snapshotWarnThreshold = msec;
+}
+
+/*
+ *  @brief  获取只读快照统计
+ *  @param  无
+ *  @retval 快照次数/长快照次数/耗时(毫秒) 当前快照的已持续时长 无快照为-1
+ */
+ESSnapshotStats EasySQLite::snapshotStats(){
+    ESSnapshotStats stats = m_snapshotStats;
+    stats.activeDuration = m_isSnapshot?m_snapshotTimer.elapsed():-1;
+    return stats;
+}
+
+EasySQLiteSnapshot::EasySQLiteSnapshot(EasySQLite *easySQLite)
+    :m_easySQLite(easySQLite){
+    m_isActive = m_easySQLite->snapshotBegin();
+}
+
+EasySQLiteSnapshot::~EasySQLiteSnapshot(){
+    if(m_isActive){
+        m_easySQLite->snapshotEnd();
+    }
+}
+
+/*
+ *  @brief  快照是否开启成功
+ *  @param  无
+ *  @retval 是否活跃
+ */
+bool EasySQLiteSnapshot::isActive(){
+    return m_isActive;
+}
+
+EasySQLite::TraceScope::~TraceScope(){
+    m_easySQLite->m_traceDepth--;
+    if(!m_isActive||m_easySQLite->m_traceStream==nullptr){
+        return;
+    }
+    qint64 duration = m_easySQLite->m_traceTimer.nsecsElapsed()/1000-m_startTime;
+    *m_easySQLite->m_traceStream<<static_cast<quint8>(m_method)<<m_startTime<<duration<<m_tableName<<m_argList;
+}
+
+QVariant EasySQLite::traceArg(const QVariant &arg){
+    return arg;
+}
+
+QVariant EasySQLite::traceArg(const QList<QVariantList> &arg){
+    QVariantList ret;
+    ret.reserve(arg.size());
+    for (int var = 0; var < arg.size(); ++var) {
+        ret.append(QVariant(arg.at(var)));
+    }
+    return ret;
+}
+
+QVariant EasySQLite::traceArg(const SortPolicy &arg){
+    return static_cast<int>(arg);
+}
+
+QVariant EasySQLite::traceArg(const QList<QPair<Aggregate,QString>> &arg){
+    QVariantList ret;
+    ret.reserve(arg.size());
+    for (int var = 0; var < arg.size(); ++var) {
+        ret.append(QVariant(QVariantList{static_cast<int>(arg.at(var).first),arg.at(var).second}));
+    }
+    return ret;
+}
+
+QVariant EasySQLite::traceArg(const QList<QPair<QVariant,QVariant>> &arg){
+    QVariantList ret;
+    ret.reserve(arg.size());
+    for (int var = 0; var < arg.size(); ++var) {
+        ret.append(QVariant(QVariantList{arg.at(var).first,arg.at(var).second}));
+    }
+    return ret;
+}
+
+//BLOB内容不记录 只记录剩余字节数 顺序设备记为-1
+QVariant EasySQLite::traceArg(QIODevice *arg){
+    if(arg==nullptr||arg->isSequential()){
+        return qint64(-1);
+    }
+    return arg->size()-arg->pos();
+}
+
+QVariant EasySQLite::traceArg(const QList<ESWrite> &arg){
+    QVariantList ret;
+    ret.reserve(arg.size());
+    for (int var = 0; var < arg.size(); ++var) {
+        const ESWrite& write = arg.at(var);
+        ret.append(QVariant(QVariantList{static_cast<int>(write.kind),write.tableName,write.fieldNameList,
+                                         QVariant(write.values),write.primarykeyValue}));
+    }
+    return ret;
+}
+
+QVariant EasySQLite::traceArg(const QList<ESRead> &arg){
+    QVariantList ret;
+    ret.reserve(arg.size());
+    for (int var = 0; var < arg.size(); ++var) {
+        const ESRead& read = arg.at(var);
+        ret.append(QVariant(QVariantList{static_cast<int>(read.kind),read.tableName,read.fieldNameList,read.condition,
+                                         read.sortFieldName,static_cast<int>(read.sortPolicy),read.primarykeyValue}));
+    }
+    return ret;
+}
+
+static const quint32 s_traceMagic = 0x45535452;//ESTR
+//版本2在文件头记录初始化配置
+static const quint16 s_traceVersion = 2;
+
+/*
+ *  @brief  提取影响调用行为的初始化配置 写入轨迹文件头 供重放时重新登记
+ *          表格/索引/默认数据已在数据库文件中 不记录
+ *  @param  初始化配置结构体
+ *  @retval 配置表
+ */
+QVariantMap EasySQLite::traceConfigSave(ESConfig *config){
+    QVariantMap ret;
+    ret.insert("readPoolSize",config->readPoolSize());
+    ret.insert("resultCacheSize",config->resultCacheSize());
+    ret.insert("busyPolicy",QVariantList{config->busyTimeout(),config->busyRetryNum(),config->busyBackoff(),config->busyBackoffMax()});
+    ret.insert("ttlPurgeInterval",config->ttlPurgeInterval());
+    ret.insert("ttlPurgeBatch",config->ttlPurgeBatch());
+
+    QVariantList tableList;
+    for (int tableIndex = 0; tableIndex < config->shardedTableNum(); ++tableIndex) {
+        tableList.append(QVariant(QVariantList{config->shardedTablename(tableIndex),config->shardedDefinition(tableIndex),
+                                               config->shardNum(tableIndex)}));
+    }
+    ret.insert("shardedTables",tableList);
+
+    tableList.clear();
+    for (int tableIndex = 0; tableIndex < config->partitionedTableNum(); ++tableIndex) {
+        tableList.append(QVariant(QVariantList{config->partitionedTablename(tableIndex),config->partitionedDefinition(tableIndex),
+                                               config->partitionFieldname(tableIndex),config->partitionPeriod(tableIndex),
+                                               config->partitionRetention(tableIndex)}));
+    }
+    ret.insert("partitionedTables",tableList);
+
+    tableList.clear();
+    for (int tableIndex = 0; tableIndex < config->aggregateTableNum(); ++tableIndex) {
+        tableList.append(QVariant(QVariantList{config->aggregateTablename(tableIndex),config->aggregateSourcename(tableIndex),
+                                               config->aggregateGroupFields(tableIndex),config->aggregateSumFields(tableIndex)}));
+    }
+    ret.insert("aggregateTables",tableList);
+
+    QVariantList fieldList;
+    for (int ttlIndex = 0; ttlIndex < config->ttlNum(); ++ttlIndex) {
+        fieldList.append(QVariant(QVariantList{config->ttlTablename(ttlIndex),config->ttlFieldname(ttlIndex),config->ttlSecs(ttlIndex)}));
+    }
+    ret.insert("ttlFields",fieldList);
+
+    fieldList.clear();
+    for (int fieldIndex = 0; fieldIndex < config->compressedFieldNum(); ++fieldIndex) {
+        fieldList.append(QVariant(QVariantList{config->compressedTablename(fieldIndex),config->compressedFieldname(fieldIndex),
+                                               config->compressThreshold(fieldIndex)}));
+    }
+    ret.insert("compressedFields",fieldList);
+
+    fieldList.clear();
+    for (int fieldIndex = 0; fieldIndex < config->searchFieldNum(); ++fieldIndex) {
+        fieldList.append(QVariant(QVariantList{config->searchTablename(fieldIndex),config->searchFieldname(fieldIndex)}));
+    }
+    ret.insert("searchFields",fieldList);
+    return ret;
+}
+
+/*
+ *  @brief  把轨迹文件头记录的配置登记到初始化配置结构体
+ *  @param  配置表
+ *  @param  初始化配置结构体(输出) 数据库路径不变
+ *  @retval 无
+ */
+void EasySQLite::traceConfigApply(const QVariantMap &configMap, ESConfig *config){
+    config->setReadPoolSize(configMap.value("readPoolSize").toInt());
+    config->setResultCacheSize(configMap.value("resultCacheSize").toLongLong());
+    const QVariantList busyPolicy = configMap.value("busyPolicy").toList();
+    if(busyPolicy.size()==4){
+        config->setBusyPolicy(busyPolicy.at(0).toInt(),busyPolicy.at(1).toInt(),busyPolicy.at(2).toInt(),busyPolicy.at(3).toInt());
+    }
+    config->setTTLPurgeInterval(configMap.value("ttlPurgeInterval",config->ttlPurgeInterval()).toInt());
+    config->setTTLPurgeBatch(configMap.value("ttlPurgeBatch",config->ttlPurgeBatch()).toInt());
+
+    const QVariantList shardedList = configMap.value("shardedTables").toList();
+    for (int var = 0; var < shardedList.size(); ++var) {
+        const QVariantList table = shardedList.at(var).toList();
+        config->newShardedTable(table.value(0).toString(),table.value(1).toString(),table.value(2).toInt());
+    }
+    const QVariantList partitionedList = configMap.value("partitionedTables").toList();
+    for (int var = 0; var < partitionedList.size(); ++var) {
+        const QVariantList table = partitionedList.at(var).toList();
+        config->newPartitionedTable(table.value(0).toString(),table.value(1).toString(),table.value(2).toString(),
+                                    table.value(3).toInt(),table.value(4).toInt());
+    }
+    const QVariantList aggregateList = configMap.value("aggregateTables").toList();
+    for (int var = 0; var < aggregateList.size(); ++var) {
+        const QVariantList table = aggregateList.at(var).toList();
+        config->newAggregateTable(table.value(0).toString(),table.value(1).toString(),table.value(2).toStringList(),
+                                  table.value(3).toStringList());
+    }
+    const QVariantList ttlList = configMap.value("ttlFields").toList();
+    for (int var = 0; var < ttlList.size(); ++var) {
+        const QVariantList field = ttlList.at(var).toList();
+        config->newTTL(field.value(0).toString(),field.value(1).toString(),field.value(2).toInt());
+    }
+    const QVariantList compressedList = configMap.value("compressedFields").toList();
+    for (int var = 0; var < compressedList.size(); ++var) {
+        const QVariantList field = compressedList.at(var).toList();
+        config->newCompressedField(field.value(0).toString(),field.value(1).toString(),field.value(2).toInt());
+    }
+    const QVariantList searchList = configMap.value("searchFields").toList();
+    for (int var = 0; var < searchList.size(); ++var) {
+        const QVariantList field = searchList.at(var).toList();
+        config->newSearchField(field.value(0).toString(),field.value(1).toString());
+    }
+}
+
+/*
+ *  @brief  开始把公开调用(方法/表格/参数/耗时)记录到二进制轨迹文件
+ *  @param  轨迹文件路径 已存在则覆盖
+ *  @retval 是否开始成功
+ */
+bool EasySQLite::traceStart(const QString &filePath){
+    traceStop();
+
+    m_traceFile = new QFile(filePath);
+    if(!m_traceFile->open(QIODevice::WriteOnly|QIODevice::Truncate)){
+        m_errorInfo = "[EasySQLite/Error]轨迹记录报错: 文件打开失败 " + m_traceFile->errorString();
+        delete m_traceFile;
+        m_traceFile = nullptr;
+        return false;
+    }
+    m_traceStream = new QDataStream(m_traceFile);
+    m_traceStream->setVersion(QDataStream::Qt_6_0);
+    *m_traceStream<<s_traceMagic<<s_traceVersion<<m_traceConfig;
+    m_traceTimer.start();
+    return true;
+}
+
+/*
+ *  @brief  停止记录并关闭轨迹文件
+ *  @param  无
+ *  @retval 无
+ */
+void EasySQLite::traceStop(){
+    if(m_traceFile==nullptr){
+        return;
+    }
+    delete m_traceStream;
+    m_traceStream = nullptr;
+    m_traceFile->close();
+    delete m_traceFile;
+    m_traceFile = nullptr;
+}
+
+/*
+ *  @brief  读取轨迹文件
+ *  @param  轨迹文件路径
+ *  @param  调用记录列表(输出)
+ *  @param  错误信息(输出)
+ *  @param  初始化配置结构体(输出) 登记记录时的分片/分区/过期/压缩等配置 为空时不登记
+ *  @retval 是否读取成功
+ */
+bool EasySQLite::traceLoad(const QString &filePath, QList<ESTraceRecord> &recordList, QString &errorInfo, ESConfig *config){
+    QFile file(filePath);
+    if(!file.open(QIODevice::ReadOnly)){
+        errorInfo = "[EasySQLite/Error]轨迹读取报错: 文件打开失败 " + file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint16 version = 0;
+    stream>>magic>>version;
+    if(magic!=s_traceMagic||version<1||version>s_traceVersion){
+        errorInfo = "[EasySQLite/Error]轨迹读取报错: 文件格式或版本不匹配";
+        return false;
+    }
+    //版本1没有记录配置
+    QVariantMap configMap;
+    if(version>=2){
+        stream>>configMap;
+    }
+    if(config!=nullptr){
+        traceConfigApply(configMap,config);
+    }
+
+    recordList.clear();
+    while(!stream.atEnd()){
+        quint8 method = 0;
+        ESTraceRecord record;
+        stream>>method>>record.startTime>>record.duration>>record.tableName>>record.argList;
+        if(stream.status()!=QDataStream::Ok){
+            //进程异常退出时最后一条可能不完整 丢弃
+            break;
+        }
+        record.method = static_cast<TraceMethod>(method);
+        recordList.append(record);
+    }
+    return true;
+}
+
+/*
+ *  @brief  按记录重新执行一次调用
+ *  @param  调用记录
+ *  @retval 调用是否成功 value()以返回值是否有效判断
+ */
+bool EasySQLite::traceReplay(const ESTraceRecord &record){
+    const QVariantList& argList = record.argList;
+    const QString& tableName = record.tableName;
+    QVariant newValue;
+    switch (record.method) {
+    case TraceMethod::RecordInsert:
+        return recordInsert(tableName,argList.value(0).toList());
+    case TraceMethod::RecordsInsert:{
+        QList<QVariantList> valuesList;
+        const QVariantList rowList = argList.value(0).toList();
+        for (int var = 0; var < rowList.size(); ++var) {
+            valuesList.append(rowList.at(var).toList());
+        }
+        return recordsInsert(tableName,valuesList);
+    }
+    case TraceMethod::RecordDelete:
+        return recordDelete(tableName,argList.value(0));
+    case TraceMethod::RecordsDelete:
+        return recordsDelete(tableName,argList.value(0).toList());
+    case TraceMethod::RecordSelectTableAll:
+        return recordSelectTableAll(tableName);
+    case TraceMethod::RecordSelect:
+        return recordSelect(tableName,argList.value(0).toStringList(),argList.value(1).toString(),
+                            argList.value(2).toString(),static_cast<SortPolicy>(argList.value(3).toInt()));
+    case TraceMethod::FieldUpdateValue:
+        return fieldUpdateValue(tableName,argList.value(0).toString(),argList.value(1),
+                                argList.value(2).toString(),argList.value(3));
+    case TraceMethod::FieldUpdate:
+        return fieldUpdate(tableName,argList.value(0).toString(),argList.value(1),argList.value(2).toString());
+    case TraceMethod::Value:
+        return value(tableName,argList.value(0),argList.value(1).toString()).isValid();
+    case TraceMethod::IsValueExist:
+        return isValueExist(tableName,argList.value(0),argList.value(1).toString(),argList.value(2));
+    case TraceMethod::FieldIncrement:
+        return fieldIncrement(tableName,argList.value(0),argList.value(1).toString(),argList.value(2),newValue);
+    case TraceMethod::FieldAppend:
+        return fieldAppend(tableName,argList.value(0),argList.value(1).toString(),argList.value(2),newValue);
+    case TraceMethod::FieldsIncrement:{
+        QList<QPair<QVariant,QVariant>> primarykeyDeltaList;
+        const QVariantList pairList = argList.value(1).toList();
+        for (int var = 0; var < pairList.size(); ++var) {
+            const QVariantList pair = pairList.at(var).toList();
+            primarykeyDeltaList.append(qMakePair(pair.value(0),pair.value(1)));
+        }
+        QVariantList newValueList;
+        return fieldsIncrement(tableName,argList.value(0).toString(),primarykeyDeltaList,newValueList);
+    }
+    case TraceMethod::RecordAggregate:{
+        QList<QPair<Aggregate,QString>> aggregateList;
+        const QVariantList pairList = argList.value(0).toList();
+        for (int var = 0; var < pairList.size(); ++var) {
+            const QVariantList pair = pairList.at(var).toList();
+            aggregateList.append(qMakePair(static_cast<Aggregate>(pair.value(0).toInt()),pair.value(1).toString()));
+        }
+        QList<QVariantList> resultList;
+        return recordAggregate(tableName,aggregateList,argList.value(1).toStringList(),argList.value(2).toString(),resultList);
+    }
+    case TraceMethod::RecordFetch:{
+        QVariantMap row;
+        return recordFetch(tableName,argList.value(0),argList.value(1).toStringList(),row)!=FetchResult::Error;
+    }
+    case TraceMethod::RecordsFetch:{
+        QHash<QString,QVariantMap> rowHash;
+        QVariantList missingKeyList;
+        return recordsFetch(tableName,argList.value(0).toList(),argList.value(1).toStringList(),rowHash,missingKeyList);
+    }
+    case TraceMethod::RecordSelectResultSet:{
+        ESResultSet resultSet;
+        return recordSelect(tableName,argList.value(0).toStringList(),argList.value(1).toString(),
+                            argList.value(2).toString(),static_cast<SortPolicy>(argList.value(3).toInt()),resultSet);
+    }
+    case TraceMethod::RecordInsertBlob:
+    case TraceMethod::BlobWrite:{
+        //按记录的字节数生成填充内容
+        QBuffer buffer;
+        buffer.setData(QByteArray(qMax(argList.value(2).toLongLong(),qint64(0)),'\0'));
+        buffer.open(QIODevice::ReadOnly);
+        if(record.method==TraceMethod::RecordInsertBlob){
+            return recordInsertBlob(tableName,argList.value(0).toList(),argList.value(1).toString(),&buffer);
+        }
+        return blobWrite(tableName,argList.value(0),argList.value(1).toString(),&buffer);
+    }
+    case TraceMethod::BlobRead:{
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        return blobRead(tableName,argList.value(0),argList.value(1).toString(),&buffer);
+    }
+    case TraceMethod::ReadParallel:{
+        QList<ESRead> readList;
+        const QVariantList readArgList = argList.value(0).toList();
+        for (int var = 0; var < readArgList.size(); ++var) {
+            const QVariantList readArg = readArgList.at(var).toList();
+            ESRead read;
+            read.kind = static_cast<ESRead::Kind>(readArg.value(0).toInt());
+            read.tableName = readArg.value(1).toString();
+            read.fieldNameList = readArg.value(2).toStringList();
+            read.condition = readArg.value(3).toString();
+            read.sortFieldName = readArg.value(4).toString();
+            read.sortPolicy = static_cast<SortPolicy>(readArg.value(5).toInt());
+            read.primarykeyValue = readArg.value(6);
+            readList.append(read);
+        }
+        QList<ESReadResult> resultList;
+        return readParallel(readList,resultList);
+    }
+    case TraceMethod::TransactionBegin:
+        return transactionBegin();
+    case TraceMethod::TransactionCommit:
+        return transactionCommit();
+    case TraceMethod::TransactionRollback:
+        return transactionRollback();
+    case TraceMethod::WriteBatch:{
+        QList<ESWrite> writeList;
+        const QVariantList writeArgList = argList.value(0).toList();
+        for (int var = 0; var < writeArgList.size(); ++var) {
+            const QVariantList writeArg = writeArgList.at(var).toList();
+            ESWrite write;
+            write.kind = static_cast<ESWrite::Kind>(writeArg.value(0).toInt());
+            write.tableName = writeArg.value(1).toString();
+            write.fieldNameList = writeArg.value(2).toStringList();
+            write.values = writeArg.value(3).toList();
+            write.primarykeyValue = writeArg.value(4);
+            writeList.append(write);
+        }
+        QList<ESWriteResult> resultList;
+        return writeBatch(writeList,resultList);
+    }
+    case TraceMethod::SnapshotBegin:
+        return snapshotBegin();
+    case TraceMethod::SnapshotEnd:
+        return snapshotEnd();
+    case TraceMethod::PartitionDrop:
+        return partitionDrop(tableName,argList.value(0).toLongLong());
+    case TraceMethod::AggregateRebuild:
+        return aggregateRebuild(tableName);
+    case TraceMethod::SchemaExec:{
+        //编译期表结构接口 按记录的SQL语句与绑定值执行
+        if(!m_database.isOpen()&&!databaseOpen()){
+            m_errorInfo = "[EasySQLite/Error]轨迹重放报错: 数据库打开失败";
+            return false;
+        }
+        const QStringList sqlList = argList.value(0).toStringList();
+        const QVariantList bindList = argList.value(1).toList();
+        QSqlQuery query;
+        for (int var = 0; var < sqlList.size(); ++var) {
+            query.prepare(sqlList.at(var));
+            for (int bindNo = 0; bindNo < bindList.size(); ++bindNo) {
+                query.addBindValue(bindList.at(bindNo));
+            }
+            if(!queryExec(query)){
+                m_errorInfo = "[EasySQLite/Error]轨迹重放报错: 执行SQL语句错误" + query.lastError().text();
+                return false;
+            }
+        }
+        query.finish();
+        databaseClose();
+        return true;
+    }
+    }
+    m_errorInfo = "[EasySQLite/Error]轨迹重放报错: 未知方法";
+    return false;
+}
+
+/*
+ *  @brief  按主键一次读取整行或多个字段
+ *  @param  表格名
+ *  @param  主键值
+ *  @param  字段名列表 为空表示全部字段
+ *  @param  字段名到数值的映射(输出)
+ *  @retval Found/NotFound 其余错误为Error 错误信息见errorInfo()
+ */
+EasySQLite::FetchResult EasySQLite::recordFetch(const QString &tableName, const QVariant &primarykeyValue,
+                                                const QStringList &fieldNameList, QVariantMap &row){
+    TraceScope trace(this,TraceMethod::RecordFetch,tableName,primarykeyValue,fieldNameList);
+
+    if(m_shardNumHash.contains(tableName)||m_partitionHash.contains(tableName)){
+        m_errorInfo = "[EasySQLite/Error]整行读取报错: 分片表与分区表不支持";
+        return FetchResult::Error;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]整行读取报错: 数据库打开失败";
+            return FetchResult::Error;
+        }
+    }
+
+    //用缓存的表结构校验字段
+    TableSchema schema;
+    if(!m_database.tables().contains(tableName)||!tableSchema(tableName,schema)){
+        m_errorInfo = "[EasySQLite/Error]整行读取报错: 表格不存在";
+        return FetchResult::Error;
+    }
+    if(schema.primarykeyName.isEmpty()){
+        m_errorInfo = "[EasySQLite/Error]整行读取报错: 表格没有主键";
+        return FetchResult::Error;
+    }
+    QStringList selectList = fieldNameList.isEmpty()?schema.fieldNameList:fieldNameList;
+    for (int var = 0; var < selectList.size(); ++var) {
+        if(!schema.fieldNameList.contains(selectList.at(var))){
+            m_errorInfo = "[EasySQLite/Error]整行读取报错: 字段名不存在 " + selectList.at(var);
+            return FetchResult::Error;
+        }
+    }
+
+    //一条语句按主键取出全部所需字段
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT %1 FROM %2 WHERE %3 = ?").arg(selectList.join(","),tableName,schema.primarykeyName));
+    query.addBindValue(primarykeyValue);
+    if(!queryExec(query)){
+        m_errorInfo = "[EasySQLite/Error]整行读取报错: 执行SQL语句查询错误" + query.lastError().text();
+        return FetchResult::Error;
+    }
+
+    row.clear();
+    FetchResult ret = FetchResult::NotFound;
+    if(query.next()){
+        for (int var = 0; var < selectList.size(); ++var) {
+            QVariant value = query.value(var);
+            if(!decompressValue(tableName,selectList.at(var),value)){
+                row.clear();
+                return FetchResult::Error;
+            }
+            row.insert(selectList.at(var),value);
+        }
+        ret = FetchResult::Found;
+    }
+
+    query.finish();
+    databaseClose();
+    return ret;
+}
+
+/*
+ *  @brief  按主键列表批量读取多行 同一读事务内完成
+ *          主键个数不多时分块使用WHERE pk IN (?,...) 很多时写入临时表后联表查询
+ *  @param  表格名
+ *  @param  主键值列表
+ *  @param  字段名列表 为空表示全部字段
+ *  @param  主键值(字符串形式)到行的映射(输出)
+ *  @param  不存在的主键值列表(输出)
+ *  @retval 是否读取成功
+ */
+bool EasySQLite::recordsFetch(const QString &tableName, const QVariantList &primarykeyValueList, const QStringList &fieldNameList,
+                              QHash<QString,QVariantMap> &rowHash, QVariantList &missingKeyList){
+    TraceScope trace(this,TraceMethod::RecordsFetch,tableName,primarykeyValueList,fieldNameList);
+
+    //IN列表每块的主键数 不超过SQLite旧版本999个变量的限制
+    const int chunkSize = 500;
+    //超过该数量改用临时表联表
+    const int tempTableThreshold = 4*chunkSize;
+
+    rowHash.clear();
+    missingKeyList.clear();
+    if(m_shardNumHash.contains(tableName)||m_partitionHash.contains(tableName)){
+        m_errorInfo = "[EasySQLite/Error]批量读取报错: 分片表与分区表不支持";
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]批量读取报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //用缓存的表结构校验字段
+    TableSchema schema;
+    if(!m_database.tables().contains(tableName)||!tableSchema(tableName,schema)){
+        m_errorInfo = "[EasySQLite/Error]批量读取报错: 表格不存在";
+        return false;
+    }
+    if(schema.primarykeyName.isEmpty()){
+        m_errorInfo = "[EasySQLite/Error]批量读取报错: 表格没有主键";
+        return false;
+    }
+    QStringList selectList = fieldNameList.isEmpty()?schema.fieldNameList:fieldNameList;
+    for (int var = 0; var < selectList.size(); ++var) {
+        if(!schema.fieldNameList.contains(selectList.at(var))){
+            m_errorInfo = "[EasySQLite/Error]批量读取报错: 字段名不存在 " + selectList.at(var);
+            return false;
+        }
+    }
+    QString fieldName = "t." + schema.primarykeyName;
+    for (int var = 0; var < selectList.size(); ++var) {
+        fieldName += ",t." + selectList.at(var);
+    }
+
+    //没有进行中的事务或快照时 自行开启读事务 保证各块读到同一时刻的数据
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    bool isOwnTransaction = m_transactionDepth==0;
+    if(isOwnTransaction&&!query.exec("BEGIN DEFERRED")){
+        m_errorInfo = "[EasySQLite/Error]批量读取报错: 读事务开启失败" + query.lastError().text();
+        databaseClose();
+        return false;
+    }
+
+    //读取一批结果 第0列为主键 压缩字段解压失败时中止
+    bool isDecompressFailed = false;
+    auto rowRead = [&](QSqlQuery& rowQuery){
+        while(!isDecompressFailed&&rowQuery.next()){
+            QVariantMap row;
+            for (int var = 0; var < selectList.size(); ++var) {
+                QVariant value = rowQuery.value(var+1);
+                if(!decompressValue(tableName,selectList.at(var),value)){
+                    isDecompressFailed = true;
+                    break;
+                }
+                row.insert(selectList.at(var),value);
+            }
+            rowHash.insert(rowQuery.value(0).toString(),row);
+        }
+        rowQuery.finish();
+        return !isDecompressFailed;
+    };
+
+    bool isSuccess = true;
+    //只读快照与只读模式禁止写临时表 仍分块查询
+    if(primarykeyValueList.size()>tempTableThreshold&&!m_isSnapshot&&!m_readOnlyMode){
+        isSuccess = query.exec("CREATE TEMP TABLE IF NOT EXISTS easysqlite_fetch_key(k PRIMARY KEY)")
+                    &&query.exec("DELETE FROM temp.easysqlite_fetch_key")
+                    &&query.prepare("INSERT OR IGNORE INTO temp.easysqlite_fetch_key VALUES(?)");
+        if(isSuccess){
+            query.addBindValue(primarykeyValueList);
+            isSuccess = query.execBatch();
+        }
+        if(isSuccess){
+            isSuccess = queryExec(query,QString("SELECT %1 FROM %2 t JOIN temp.easysqlite_fetch_key k ON t.%3 = k.k")
+                                              .arg(fieldName,tableName,schema.primarykeyName));
+        }
+        if(isSuccess){
+            isSuccess = rowRead(query);
+            query.exec("DELETE FROM temp.easysqlite_fetch_key");
+        }
+    }else{
+        for (int begin = 0; begin < primarykeyValueList.size()&&isSuccess; begin += chunkSize) {
+            int num = qMin(chunkSize,static_cast<int>(primarykeyValueList.size())-begin);
+            QString placeholder = QString("?,").repeated(num);
+            placeholder.chop(1);
+            query.prepare(QString("SELECT %1 FROM %2 t WHERE t.%3 IN (%4)")
+                              .arg(fieldName,tableName,schema.primarykeyName,placeholder));
+            for (int var = 0; var < num; ++var) {
+                query.addBindValue(primarykeyValueList.at(begin+var));
+            }
+            isSuccess = queryExec(query);
+            if(isSuccess){
+                isSuccess = rowRead(query);
+            }
+        }
+    }
+    if(!isSuccess&&!isDecompressFailed){
+        m_errorInfo = "[EasySQLite/Error]批量读取报错: 执行SQL语句查询错误" + query.lastError().text();
+    }
+
+    if(isOwnTransaction){
+        query.exec(isSuccess?"COMMIT":"ROLLBACK");
+    }
+    if(!isSuccess){
+        rowHash.clear();
+        databaseClose();
+        return false;
+    }
+
+    //找出不存在的主键
+    for (int var = 0; var < primarykeyValueList.size(); ++var) {
+        if(!rowHash.contains(primarykeyValueList.at(var).toString())){
+            missingKeyList.append(primarykeyValueList.at(var));
+        }
+    }
+
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  只读模式下拒绝写操作
+ *  @param  报错标题
+ *  @retval 是否拒绝 拒绝时设置错误信息
+ */
+bool EasySQLite::isWriteRejected(const QString &title){
+    if(!m_readOnlyMode){
+        return false;
+    }
+    m_errorInfo = QString("[EasySQLite/Error]%1报错: 只读模式不允许写入").arg(title);
+    return true;
+}
+
+//默认连接为进程内共用 busy处理函数的等待次数与计时同样进程内共用
+static int s_busyHandlerNum = 0;
+static QElapsedTimer s_busyHandlerTimer;
+
+/*
+ *  @brief  SQLite busy处理函数 按与busy_timeout相同的等待序列休眠 超过busy_timeout后放弃
+ *  @param  EasySQLite对象
+ *  @param  本次锁冲突中已调用的次数
+ *  @retval 非0继续等待 0放弃并返回SQLITE_BUSY
+ */
+int EasySQLite::busyHandlerCallback(void *easySQLite, int count){
+    int busyTimeout = static_cast<EasySQLite*>(easySQLite)->m_busyTimeout;
+    if(count==0){
+        s_busyHandlerTimer.start();
+    }
+    s_busyHandlerNum++;
+    qint64 elapsed = s_busyHandlerTimer.elapsed();
+    if(elapsed>=busyTimeout){
+        return 0;
+    }
+    static const int delayList[] = {1,2,5,10,15,20,25,25,25,50,50,100};
+    int delay = delayList[qMin(count,static_cast<int>(std::size(delayList))-1)];
+    QThread::msleep(static_cast<unsigned long>(qMin<qint64>(delay,busyTimeout-elapsed)));
+    return 1;
+}
+
+/*
+ *  @brief  执行SQL语句 遇到SQLITE_BUSY/LOCKED时按抖动指数退避重试
+ *          busy处理函数在busy_timeout内等待过也计入锁等待统计
+ *          事务中的普通语句不重试 其失败需要调用方回滚整个事务
+ *  @param  查询对象
+ *  @param  SQL语句 为空时执行已准备的语句
+ *  @param  是否为BEGIN/COMMIT等事务控制语句 事务中也允许重试
+ *  @retval 是否执行成功
+ */
+bool EasySQLite::busyRetryExec(QSqlQuery &query, const QString &sql, bool isTransactionControl){
+    QElapsedTimer timer;
+    timer.start();
+    s_busyHandlerNum = 0;
+    bool ret = sql.isEmpty()?query.exec():query.exec(sql);
+    //扩展错误码低8位为主错误码
+    int code = ret?SQLITE_OK:(query.lastError().nativeErrorCode().toInt()&0xff);
+    bool isBusy = code==SQLITE_BUSY||code==SQLITE_LOCKED;
+    //busy处理函数未等待过且不是锁冲突 与锁竞争无关
+    if(s_busyHandlerNum==0&&!isBusy){
+        changeCommitResolve(sqliteHandle(m_database));
+        return ret;
+    }
+
+    QString operation = (sql.isEmpty()?query.lastQuery():sql).trimmed().section(' ',0,0).toUpper();
+    ESBusyStats& stats = m_busyStatsHash[operation];
+    stats.busyNum++;
+    if(isBusy&&(m_transactionDepth==0||isTransactionControl)){
+        int backoff = m_busyBackoff;
+        for (int retryIndex = 0; retryIndex < m_busyRetryNum&&!ret; ++retryIndex) {
+            //在退避时长的一半到全部之间随机 避免多个进程同时醒来再次冲突
+            QThread::msleep(static_cast<unsigned long>(backoff/2+QRandomGenerator::global()->bounded(backoff/2+1)));
+            backoff = qMin(backoff*2,m_busyBackoffMax);
+            stats.retryNum++;
+            ret = sql.isEmpty()?query.exec():query.exec(sql);
+            if(!ret){
+                code = query.lastError().nativeErrorCode().toInt()&0xff;
+                if(code!=SQLITE_BUSY&&code!=SQLITE_LOCKED){
+                    break;
+                }
+            }
+        }
+    }
+
+    qint64 wait = timer.nsecsElapsed()/1000;
+    stats.totalWait += wait;
+    stats.maxWait = qMax(stats.maxWait,wait);
+    if(!ret){
+        stats.failNum++;
+    }
+    changeCommitResolve(sqliteHandle(m_database));
+    return ret;
+}
+
+/*
+ *  @brief  获取锁等待统计
+ *  @param  无
+ *  @retval SQL语句类型到统计的映射
+ */
+QHash<QString,ESBusyStats> EasySQLite::busyStats(){
+    return m_busyStatsHash;
+}
+
+//压缩值的标记头 后跟1字节原始类型 'T'文本 'B'二进制
+static const QByteArray s_compressMarker = QByteArrayLiteral("ESZ\x01");
+
+/*
+ *  @brief  判断是否为压缩字段
+ *  @param  表格名
+ *  @param  字段名
+ *  @retval 是否为压缩字段
+ */
+bool EasySQLite::isCompressedField(const QString &tableName, const QString &fieldName){
+    auto iterator = m_compressHash.constFind(tableName);
+    return iterator!=m_compressHash.cend()&&iterator->contains(fieldName);
+}
+
+/*
+ *  @brief  压缩字段的值超过阈值时压缩为带标记头的BLOB
+ *  @param  表格名
+ *  @param  字段名
+ *  @param  原始值
+ *  @param  压缩后的数据(输出)
+ *  @retval 是否压缩 不是压缩字段/不是文本或二进制/未超过阈值时为false
+ */
+bool EasySQLite::compressValue(const QString &tableName, const QString &fieldName, const QVariant &value, QByteArray &compressed){
+    if(!isCompressedField(tableName,fieldName)){
+        return false;
+    }
+    bool isText = value.typeId()==QMetaType::QString;
+    if(!isText&&value.typeId()!=QMetaType::QByteArray){
+        return false;
+    }
+    QByteArray raw = isText?value.toString().toUtf8():value.toByteArray();
+    if(raw.size()<m_compressHash[tableName].value(fieldName)){
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    compressed = s_compressMarker;
+    compressed.append(isText?'T':'B');
+    compressed.append(qCompress(raw));
+    m_compressStats.compressNum++;
+    m_compressStats.rawBytes += raw.size();
+    m_compressStats.compressedBytes += compressed.size();
+    m_compressStats.compressTime += timer.nsecsElapsed()/1000;
+    return true;
+}
+
+/*
+ *  @brief  转换为SQL格式 压缩后的值使用BLOB字面量 其余同value2SqlFormat
+ *  @param  表格名
+ *  @param  字段名
+ *  @param  数值
+ *  @retval SQL格式的数值字符串 例: "X'45535a0154...'"
+ */
+QString EasySQLite::compressedValue2SqlFormat(const QString &tableName, const QString &fieldName, const QVariant &value){
+    QByteArray compressed;
+    if(compressValue(tableName,fieldName,value,compressed)){
+        return QString("X'%1'").arg(QString::fromLatin1(compressed.toHex()));
+    }
+    return value2SqlFormat(value);
+}
+
+/*
+ *  @brief  按字段顺序转换整行为SQL格式 压缩字段先压缩
+ *  @param  表格名
+ *  @param  整行数据
+ *  @retval SQL格式的拼接字符串
+ */
+QString EasySQLite::compressedValues2SqlFormat(const QString &tableName, const QVariantList &values){
+    if(!m_compressHash.contains(tableName)){
+        return values2SqlFormat(values);
+    }
+    //分区表按逻辑表的字段顺序 其余按表格结构
+    QStringList fieldNameList;
+    TableSchema schema;
+    if(m_partitionHash.contains(tableName)){
+        fieldNameList = m_partitionHash.value(tableName).fieldNameList;
+    }else if(tableSchema(tableName,schema)){
+        fieldNameList = schema.fieldNameList;
+    }else{
+        return values2SqlFormat(values);
+    }
+    QStringList strValueList;
+    for (int var = 0; var < values.size(); ++var) {
+        strValueList.append(var<fieldNameList.size()?compressedValue2SqlFormat(tableName,fieldNameList.at(var),values.at(var))
+                                                    :value2SqlFormat(values.at(var)));
+    }
+    return strValueList.join(",");
+}
+
+/*
+ *  @brief  压缩字段中带标记头的值解压为原始类型
+ *  @param  表格名
+ *  @param  字段名
+ *  @param  读出的值 解压后原位替换
+ *  @retval 是否成功 数据损坏无法解压时为false
+ */
+bool EasySQLite::decompressValue(const QString &tableName, const QString &fieldName, QVariant &value){
+    if(value.typeId()!=QMetaType::QByteArray||!isCompressedField(tableName,fieldName)){
+        return true;
+    }
+    QByteArray data = value.toByteArray();
+    if(data.size()<=s_compressMarker.size()||!data.startsWith(s_compressMarker)){
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    char type = data.at(s_compressMarker.size());
+    QByteArray compressed = data.mid(s_compressMarker.size()+1);
+    QByteArray raw = qUncompress(compressed);
+    m_compressStats.decompressNum++;
+    m_compressStats.decompressTime += timer.nsecsElapsed()/1000;
+
+    //qCompress数据以4字节大端原始长度开头 原始长度非0却解压出空数据即为损坏
+    bool isEmptyRaw = compressed.size()>=4&&compressed.at(0)==0&&compressed.at(1)==0&&compressed.at(2)==0&&compressed.at(3)==0;
+    if((raw.isEmpty()&&!isEmptyRaw)||(type!='T'&&type!='B')){
+        m_errorInfo = QString("[EasySQLite/Error]解压报错: 压缩数据损坏 %1.%2").arg(tableName,fieldName);
+        return false;
+    }
+    value = type=='T'?QVariant(QString::fromUtf8(raw)):QVariant(raw);
+    return true;
+}
+
+/*
+ *  @brief  解压结果集中压缩字段的单元格 解压后的数据追加到字符串池
+ *  @param  表格名
+ *  @param  结果集
+ *  @retval 是否成功
+ */
+bool EasySQLite::resultSetDecompress(const QString &tableName, ESResultSet &resultSet){
+    if(!m_compressHash.contains(tableName)){
+        return true;
+    }
+    for (int column = 0; column < resultSet.m_columnList.size(); ++column) {
+        ESResultSet::Column& current = resultSet.m_columnList[column];
+        if(!isCompressedField(tableName,current.name)){
+            continue;
+        }
+        for (int row = 0; row < resultSet.m_rowNum; ++row) {
+            if(current.typeList.at(row)!=ESResultSet::Type::Blob){
+                continue;
+            }
+            QVariant value = QByteArray(resultSet.m_pool.constData()+current.slotList.at(row),current.lengthList.at(row));
+            if(!decompressValue(tableName,current.name,value)){
+                return false;
+            }
+            if(value.typeId()==QMetaType::QString){
+                //文本以UTF-16存入池 保证2字节对齐
+                QString text = value.toString();
+                if(resultSet.m_pool.size()%2){
+                    resultSet.m_pool.append('\0');
+                }
+                current.typeList[row] = ESResultSet::Type::Text;
+                current.slotList[row] = resultSet.m_pool.size();
+                current.lengthList[row] = static_cast<quint32>(text.size()*2);
+                resultSet.m_pool.append(reinterpret_cast<const char*>(text.utf16()),text.size()*2);
+            }else{
+                QByteArray raw = value.toByteArray();
+                current.slotList[row] = resultSet.m_pool.size();
+                current.lengthList[row] = static_cast<quint32>(raw.size());
+                resultSet.m_pool.append(raw);
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ *  @brief  创建TableModel 表格含压缩字段时读取单元格自动解压
+ *  @param  表格名
+ *  @param  已执行的查询
+ *  @retval TableModel
+ */
+QSqlTableModel *EasySQLite::tableModelCreate(const QString &tableName, QSqlQuery &query){
+    QSqlTableModel* model = m_compressHash.contains(tableName)?new CompressedTableModel(this,tableName,m_database)
+                                                              :new QSqlTableModel(this,m_database);
+    model->setQuery(query);
+    return model;
+}
+
+EasySQLite::CompressedTableModel::CompressedTableModel(EasySQLite *easySQLite, const QString &tableName, const QSqlDatabase &database)
+    :QSqlTableModel(easySQLite,database),m_easySQLite(easySQLite),m_compressTableName(tableName){}
+
+/*
+ *  @brief  读取单元格 压缩字段解压后返回
+ *  @param  单元格索引
+ *  @param  数据角色
+ *  @retval 单元格值 解压失败返回无效值 错误信息见errorInfo()
+ */
+QVariant EasySQLite::CompressedTableModel::data(const QModelIndex &index, int role) const{
+    QVariant value = QSqlTableModel::data(index,role);
+    if((role!=Qt::DisplayRole&&role!=Qt::EditRole)||value.typeId()!=QMetaType::QByteArray){
+        return value;
+    }
+
+    QString fieldName = record().fieldName(index.column());
+    if(!m_easySQLite->isCompressedField(m_compressTableName,fieldName)){
+        return value;
+    }
+
+    //原始数据未变化时直接用缓存的解压结果
+    QByteArray raw = value.toByteArray();
+    QPair<int,int> key = qMakePair(index.row(),index.column());
+    auto iterator = m_decompressHash.constFind(key);
+    if(iterator!=m_decompressHash.cend()&&iterator->first==raw){
+        return iterator->second;
+    }
+    if(!m_easySQLite->decompressValue(m_compressTableName,fieldName,value)){
+        return QVariant();
+    }
+    m_decompressHash.insert(key,qMakePair(raw,value));
+    return value;
+}
+
+/*
+ *  @brief  获取压缩统计
+ *  @param  无
+ *  @retval 压缩次数/字节数/压缩比/耗时(微秒)
+ */
+ESCompressStats EasySQLite::compressStats(){
+    return m_compressStats;
+}
+
+/*
+ *  @brief  创建物化聚合表及源表的同步触发器 默认数据库已打开
+ *  @param  聚合表名
+ *  @param  源表名
+ *  @param  分组字段名列表
+ *  @param  求和字段名列表
+ *  @retval 是否创建成功
+ *  @note   聚合表字段为 分组字段,row_count,sum_<求和字段> 分组值为NULL也单独成组
+ *          首次创建时用源表已有数据填充 组内行数减为0时删除该组
+ */
+bool EasySQLite::aggregateTableInit(const QString &aggregateName, const QString &sourceTableName,
+                                    const QStringList &groupFieldNameList, const QStringList &sumFieldNameList){
+    //判断源表与字段是否存在
+    QStringList tableFieldNameList;
+    if(groupFieldNameList.isEmpty()||!fieldNameQuery(sourceTableName,tableFieldNameList)){
+        m_errorInfo = "[EasySQLite/Error]聚合表初始化报错: 源表不存在或分组字段为空";
+        return false;
+    }
+    for (const QString& fieldName : groupFieldNameList+sumFieldNameList) {
+        if(!tableFieldNameList.contains(fieldName)){
+            m_errorInfo = "[EasySQLite/Error]聚合表初始化报错: 字段名不存在";
+            return false;
+        }
+    }
+
+    //拼接各部分 例: g1,g2 / sum_a,sum_b / g1 IS new.g1 AND g2 IS new.g2
+    QStringList sumNameList;
+    QStringList newAddList;
+    QStringList oldSubList;
+    QStringList newMatchList;
+    QStringList oldMatchList;
+    for (const QString& fieldName : sumFieldNameList) {
+        sumNameList.append("sum_"+fieldName);
+        newAddList.append(QString("sum_%1=sum_%1+coalesce(new.%1,0)").arg(fieldName));
+        oldSubList.append(QString("sum_%1=sum_%1-coalesce(old.%1,0)").arg(fieldName));
+    }
+    for (const QString& fieldName : groupFieldNameList) {
+        newMatchList.append(QString("%1 IS new.%1").arg(fieldName));
+        oldMatchList.append(QString("%1 IS old.%1").arg(fieldName));
+    }
+    QString groupFields = groupFieldNameList.join(",");
+    QString newMatch = newMatchList.join(" AND ");
+    QString oldMatch = oldMatchList.join(" AND ");
+    QString sumColumns = sumNameList.isEmpty()?QString():","+sumNameList.join(" DEFAULT 0,")+" DEFAULT 0";
+    QString sumZeros = QString(",0").repeated(sumNameList.size());
+
+    //新行计入所在组 组不存在时先建组
+    QString newApply = QString("INSERT INTO %1(%2,row_count%3) SELECT new.%4,0%5 WHERE NOT EXISTS(SELECT 1 FROM %1 WHERE %6); "
+                               "UPDATE %1 SET row_count=row_count+1%7 WHERE %6; ")
+                           .arg(aggregateName,groupFields,sumNameList.isEmpty()?QString():","+sumNameList.join(","),
+                                groupFieldNameList.join(",new."),sumZeros,newMatch,
+                                newAddList.isEmpty()?QString():","+newAddList.join(","));
+    //旧行移出所在组 组空时删除
+    QString oldApply = QString("UPDATE %1 SET row_count=row_count-1%2 WHERE %3; "
+                               "DELETE FROM %1 WHERE row_count<=0 AND %3; ")
+                           .arg(aggregateName,oldSubList.isEmpty()?QString():","+oldSubList.join(","),oldMatch);
+
+    bool isExist = m_database.tables().contains(aggregateName);
+    QString triggerName = aggregateName+"_"+sourceTableName;
+    QStringList sqlList;
+    sqlList.append(QString("CREATE TABLE IF NOT EXISTS %1(%2,row_count INTEGER NOT NULL DEFAULT 0%3)")
+                       .arg(aggregateName,groupFields,sumColumns));
+    sqlList.append(QString("CREATE UNIQUE INDEX IF NOT EXISTS %1_group ON %1(%2)").arg(aggregateName,groupFields));
+    sqlList.append(QString("CREATE TRIGGER IF NOT EXISTS %1_ai AFTER INSERT ON %2 BEGIN %3END").arg(triggerName,sourceTableName,newApply));
+    sqlList.append(QString("CREATE TRIGGER IF NOT EXISTS %1_ad AFTER DELETE ON %2 BEGIN %3END").arg(triggerName,sourceTableName,oldApply));
+    //只在分组/求和字段变化时触发 其余字段的更新不影响聚合结果
+    QStringList updateFieldNameList = groupFieldNameList;
+    updateFieldNameList.append(sumFieldNameList);
+    sqlList.append(QString("CREATE TRIGGER IF NOT EXISTS %1_au AFTER UPDATE OF %2 ON %3 BEGIN %4%5END")
+                       .arg(triggerName,updateFieldNameList.join(","),sourceTableName,oldApply,newApply));
+
+    MaterializedAggregate aggregate;
+    aggregate.sourceTableName = sourceTableName;
+    aggregate.groupFieldNameList = groupFieldNameList;
+    aggregate.sumFieldNameList = sumFieldNameList;
+    m_aggregateHash.insert(aggregateName,aggregate);
+    if(!isExist){
+        //首次创建 用源表已有数据填充
+        sqlList.append(aggregateFillSql(aggregateName));
+    }
+
+    //建表/触发器/填充在同一事务中 避免失败时留下没有触发器或未填充的聚合表
+    if(!transactionBegin()){
+        m_errorInfo = "[EasySQLite/Error]聚合表初始化报错: 事务开启失败";
+        m_aggregateHash.remove(aggregateName);
+        return false;
+    }
+    QSqlQuery query;
+    for (int var = 0; var < sqlList.size(); ++var) {
+        if(!queryExec(query,sqlList.at(var))){
+            m_errorInfo = "[EasySQLite/Error]聚合表初始化报错: 执行SQL语句错误" + query.lastError().text();
+            m_aggregateHash.remove(aggregateName);
+            QString errorInfo = m_errorInfo;
+            transactionRollback();
+            m_errorInfo = errorInfo;
+            return false;
+        }
+    }
+    if(!transactionCommit()){
+        m_aggregateHash.remove(aggregateName);
+        transactionRollback();
+        return false;
+    }
+
+    //提交后连接已关闭 初始化的后续步骤要求默认数据库已打开
+    if(!m_database.isOpen()&&!databaseOpen()){
+        m_errorInfo = "[EasySQLite/Error]聚合表初始化报错: 数据库打开失败";
+        return false;
+    }
+    return true;
+}
+
+/*
+ *  @brief  生成用源表全量数据填充聚合表的SQL
+ *  @param  聚合表名
+ *  @retval SQL语句
+ */
+QString EasySQLite::aggregateFillSql(const QString &aggregateName){
+    const MaterializedAggregate& aggregate = m_aggregateHash[aggregateName];
+    QString groupFields = aggregate.groupFieldNameList.join(",");
+    QString sumNames;
+    QString sums;
+    for (const QString& fieldName : aggregate.sumFieldNameList) {
+        sumNames += ",sum_"+fieldName;
+        sums += QString(",coalesce(sum(%1),0)").arg(fieldName);
+    }
+    return QString("INSERT INTO %1(%2,row_count%3) SELECT %2,count(*)%4 FROM %5 GROUP BY %2")
+        .arg(aggregateName,groupFields,sumNames,sums,aggregate.sourceTableName);
+}
+
+/*
+ *  @brief  判断是否为物化聚合表
+ *  @param  表格名
+ *  @retval 是否为聚合表
+ */
+bool EasySQLite::isAggregateTable(const QString &tableName){
+    return m_aggregateHash.contains(tableName);
+}
+
+/*
+ *  @brief  用源表全量数据重建聚合表 用于触发器建立前已有的写入或外部修改后校正
+ *  @param  聚合表名
+ *  @retval 是否重建成功
+ */
+bool EasySQLite::aggregateRebuild(const QString &aggregateName){
+    TraceScope trace(this,TraceMethod::AggregateRebuild,aggregateName);
+
+    //只读模式 不执行任何SQL直接拒绝
+    if(isWriteRejected("聚合表重建")){
+        return false;
+    }
+
+    if(!m_aggregateHash.contains(aggregateName)){
+        m_errorInfo = "[EasySQLite/Error]聚合表重建报错: 不是聚合表";
+        return false;
+    }
+
+    //检查数据库是否打开
+    if(!m_database.isOpen()){
+        //未打开 执行打开数据库
+        if(!databaseOpen()){
+            //打开失败
+            m_errorInfo = "[EasySQLite/Error]聚合表重建报错: 数据库打开失败";
+            return false;
+        }
+    }
+
+    //清空与填充在同一事务内 读方不会看到空表
+    if(!transactionBegin()){
+        return false;
+    }
+    QSqlQuery query;
+    if(!queryExec(query,QString("DELETE FROM %1").arg(aggregateName))||!queryExec(query,aggregateFillSql(aggregateName))){
+        m_errorInfo = "[EasySQLite/Error]聚合表重建报错: " + query.lastError().text();
+        QString errorInfo = m_errorInfo;
+        transactionRollback();
+        m_errorInfo = errorInfo;
+        return false;
+    }
+    query.finish();
+    if(!transactionCommit()){
+        transactionRollback();
+        return false;
+    }
+
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  递增表格的写版本
+ *  @param  表格名
+ *  @retval 无
+ */
+void EasySQLite::tableVersionBump(const QString &tableName){
+    QMutexLocker locker(&s_changeMutex);
+    s_tableVersionHash[tableName]++;
+}
+
+/*
+ *  @brief  递增写入纪元 使所有查询结果缓存失效
+ *  @param  无
+ *  @retval 无
+ */
+void EasySQLite::writeEpochBump(){
+    QMutexLocker locker(&s_changeMutex);
+    s_writeEpoch++;
+}
+
+/*
+ *  @brief  判断当前查询能否使用结果缓存
+ *  @param  无
+ *  @retval 是否可用
+ *  @note   事务中可能读到未提交的数据 快照中读到的是旧数据 均不读写缓存
+ */
+bool EasySQLite::isResultCacheable(){
+    return m_resultCacheSize>0&&m_transactionDepth==0&&!m_isSnapshot;
+}
+
+/*
+ *  @brief  获取查询所依赖表格的当前写版本 默认数据库已打开
+ *  @param  表格名
+ *  @param  条件字符串 其中出现的其它表格(子查询)也视为依赖
+ *  @retval 各依赖表格的写版本 末尾为写入纪元 同一查询的依赖顺序固定
+ */
+QList<quint64> EasySQLite::resultCacheVersions(const QString &tableName, const QString &condition){
+    QStringList dependList{tableName};
+    if(!condition.isEmpty()){
+        const QStringList tableList = m_database.tables();
+        static const QRegularExpression identifierRegExp("[A-Za-z_][A-Za-z0-9_]*");
+        QRegularExpressionMatchIterator iterator = identifierRegExp.globalMatch(condition);
+        while(iterator.hasNext()){
+            QString word = iterator.next().captured(0);
+            if(!dependList.contains(word)&&tableList.contains(word)){
+                dependList.append(word);
+            }
+        }
+    }
+
+    QList<quint64> ret;
+    QMutexLocker locker(&s_changeMutex);
+    for (int var = 0; var < dependList.size(); ++var) {
+        ret.append(s_tableVersionHash.value(dependList.at(var)));
+    }
+    ret.append(s_writeEpoch);
+    return ret;
+}
+
+/*
+ *  @brief  查找查询结果缓存 过期条目直接移除
+ *  @param  缓存键 规范化后的SQL
+ *  @param  依赖表格的当前写版本
+ *  @retval 命中的条目 未命中返回nullptr
+ */
+EasySQLite::ResultCacheEntry *EasySQLite::resultCacheFind(const QString &key, const QList<quint64> &versionList){
+    auto iterator = m_resultCacheHash.find(key);
+    if(iterator==m_resultCacheHash.end()){
+        m_resultCacheStats.missNum++;
+        return nullptr;
+    }
+    //写版本变化 或缓存的TableModel已被外部删除
+    bool isModelLost = key.startsWith("M|")&&iterator->model.isNull();
+    if(iterator->versionList!=versionList||isModelLost){
+        m_resultCacheStats.staleNum++;
+        m_resultCacheStats.missNum++;
+        resultCacheEvict(key);
+        return nullptr;
+    }
+    m_resultCacheStats.hitNum++;
+    iterator->lastUse = ++m_resultCacheTick;
+    return &iterator.value();
+}
+
+/*
+ *  @brief  加入查询结果缓存 超出内存预算时淘汰最久未使用的条目
+ *  @param  缓存键 规范化后的SQL
+ *  @param  缓存条目
+ *  @retval 无
+ */
+void EasySQLite::resultCacheInsert(const QString &key, const ResultCacheEntry &entry){
+    //单条即超出预算 不缓存
+    if(entry.cost>m_resultCacheSize){
+        return;
+    }
+    resultCacheEvict(key);
+    while(!m_resultCacheHash.isEmpty()&&m_resultCacheUsage+entry.cost>m_resultCacheSize){
+        auto oldest = m_resultCacheHash.cbegin();
+        for (auto iterator = m_resultCacheHash.cbegin(); iterator != m_resultCacheHash.cend(); ++iterator) {
+            if(iterator->lastUse<oldest->lastUse){
+                oldest = iterator;
+            }
+        }
+        m_resultCacheStats.evictNum++;
+        resultCacheEvict(oldest.key());
+    }
+
+    ResultCacheEntry& newEntry = m_resultCacheHash[key];
+    newEntry = entry;
+    newEntry.lastUse = ++m_resultCacheTick;
+    m_resultCacheUsage += entry.cost;
+    m_resultCacheStats.entryNum = m_resultCacheHash.size();
+    m_resultCacheStats.memoryUsage = m_resultCacheUsage;
+}
+
+/*
+ *  @brief  移除一条查询结果缓存
+ *  @param  缓存键
+ *  @retval 无
+ *  @note   TableModel仍为当前模型时保留 随父对象析构
+ */
+void EasySQLite::resultCacheEvict(const QString &key){
+    auto iterator = m_resultCacheHash.find(key);
+    if(iterator==m_resultCacheHash.end()){
+        return;
+    }
+    if(!iterator->model.isNull()&&iterator->model!=m_tableModel){
+        iterator->model->deleteLater();
+    }
+    m_resultCacheUsage -= iterator->cost;
+    m_resultCacheHash.erase(iterator);
+    m_resultCacheStats.entryNum = m_resultCacheHash.size();
+    m_resultCacheStats.memoryUsage = m_resultCacheUsage;
+}
+
+/*
+ *  @brief  获取查询结果缓存统计
+ *  @param  无
+ *  @retval 命中/未命中/过期/淘汰次数 条目数与估算内存占用
+ */
+ESResultCacheStats EasySQLite::resultCacheStats(){
+    return m_resultCacheStats;
+}
+
+/*
+ *  @brief  清空查询结果缓存
+ *  @param  无
+ *  @retval 无
+ */
+void EasySQLite::resultCacheClear(){
+    while(!m_resultCacheHash.isEmpty()){
+        resultCacheEvict(m_resultCacheHash.cbegin().key());
+    }
+}
+
+/*
+ *  @brief  事务回滚后重新读取全部分区表的分区列表 撤销回滚掉的分区建立与删除
+ *  @param  无
+ *  @retval 无
+ */
+void EasySQLite::partitionListReload(){
+    QString errorInfo = m_errorInfo;
+    const QStringList tableNameList = m_partitionHash.keys();
+    for (int var = 0; var < tableNameList.size(); ++var) {
+        partitionListLoad(tableNameList.at(var));
+    }
+    m_errorInfo = errorInfo;
+}
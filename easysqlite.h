@@ -2,13 +2,319 @@
 #define EASYSQLITE_H
 
 #include <QObject>
+#include <QIODevice>
+#include <QStringView>
+#include <QByteArrayView>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QPointer>
+#include <QMetaType>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QSqlTableModel>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+class QTimer;
+class QFile;
+class QDataStream;
+class QThreadPool;
+struct sqlite3;
+struct sqlite3_backup;
+struct sqlite3_stmt;
+
+//编译期表结构: 用户以 name/columns/indexes 三个静态成员描述表格 建表/增删改查语句在编译期生成
+//例:
+//  struct UserTable{
+//      static constexpr const char* name = "user";
+//      static constexpr ESColumn columns[] = {{"id","INTEGER",true},{"name","TEXT",false}};
+//      static constexpr ESIndex indexes[] = {{"idx_user_name","name"}};   //可省略
+//  };
+typedef struct EasySQLiteColumn{
+    const char* name;
+    const char* type;
+    bool isPrimaryKey;
+}ESColumn;
+
+typedef struct EasySQLiteIndex{
+    const char* name;
+    const char* columns;
+}ESIndex;
+
+//编译期定长字符串
+template<std::size_t N>
+struct ESFixedString{
+    char data[N]{};
+    std::size_t size=0;
+
+    constexpr void append(const char* str){
+        while(*str){
+            data[size++] = *str++;
+        }
+    }
+
+    constexpr const char* c_str() const{
+        return data;
+    }
+
+    QString toString() const{
+        return QString::fromUtf8(data,static_cast<qsizetype>(size));
+    }
+};
+
+namespace EasySQLiteSchemaDetail{
+
+enum Statement{
+    Definition,
+    Create,
+    Insert,
+    Select,
+    Update,
+    Delete,
+    Index
+};
+
+//只计长度不写入 用于确定定长字符串容量
+struct Counter{
+    std::size_t size=0;
+
+    constexpr void append(const char* str){
+        while(*str++){
+            size++;
+        }
+    }
+};
+
+template<class Table, class=void>
+struct HasIndexes : std::false_type{};
+
+template<class Table>
+struct HasIndexes<Table,std::void_t<decltype(Table::indexes)>> : std::true_type{};
+
+template<class Table>
+constexpr int indexNum(){
+    if constexpr (HasIndexes<Table>::value){
+        return static_cast<int>(std::size(Table::indexes));
+    }else{
+        return 0;
+    }
+}
+
+template<class Table>
+constexpr ESIndex indexAt(int indexNo){
+    if constexpr (HasIndexes<Table>::value){
+        return Table::indexes[indexNo];
+    }else{
+        return ESIndex{"",""};
+    }
+}
+
+template<class Table>
+constexpr int primarykeyIndex(){
+    for (int var = 0; var < static_cast<int>(std::size(Table::columns)); ++var) {
+        if(Table::columns[var].isPrimaryKey){
+            return var;
+        }
+    }
+    return -1;
+}
+
+template<class Table, class Out>
+constexpr void statementWrite(Out& out, Statement statement, int indexNo){
+    constexpr int columnNum = static_cast<int>(std::size(Table::columns));
+    constexpr int primaryIndex = primarykeyIndex<Table>();
+    switch (statement) {
+    case Definition://id INTEGER PRIMARY KEY,name TEXT
+        for (int var = 0; var < columnNum; ++var) {
+            out.append(Table::columns[var].name);
+            out.append(" ");
+            out.append(Table::columns[var].type);
+            if(Table::columns[var].isPrimaryKey){
+                out.append(" PRIMARY KEY");
+            }
+            if(var!=columnNum-1){
+                out.append(",");
+            }
+        }
+        break;
+    case Create://CREATE TABLE IF NOT EXISTS user(...)
+        out.append("CREATE TABLE IF NOT EXISTS ");
+        out.append(Table::name);
+        out.append("(");
+        statementWrite<Table>(out,Definition,0);
+        out.append(")");
+        break;
+    case Insert://INSERT INTO user VALUES(?,?)
+        out.append("INSERT INTO ");
+        out.append(Table::name);
+        out.append(" VALUES(");
+        for (int var = 0; var < columnNum; ++var) {
+            out.append(var==columnNum-1?"?":"?,");
+        }
+        out.append(")");
+        break;
+    case Select://SELECT id,name FROM user WHERE id = ?
+        out.append("SELECT ");
+        for (int var = 0; var < columnNum; ++var) {
+            out.append(Table::columns[var].name);
+            if(var!=columnNum-1){
+                out.append(",");
+            }
+        }
+        out.append(" FROM ");
+        out.append(Table::name);
+        out.append(" WHERE ");
+        out.append(Table::columns[primaryIndex].name);
+        out.append(" = ?");
+        break;
+    case Update:{//UPDATE user SET name = ? WHERE id = ?
+        out.append("UPDATE ");
+        out.append(Table::name);
+        out.append(" SET ");
+        bool isFirst = true;
+        for (int var = 0; var < columnNum; ++var) {
+            if(var==primaryIndex){
+                continue;
+            }
+            if(!isFirst){
+                out.append(",");
+            }
+            isFirst = false;
+            out.append(Table::columns[var].name);
+            out.append(" = ?");
+        }
+        out.append(" WHERE ");
+        out.append(Table::columns[primaryIndex].name);
+        out.append(" = ?");
+        break;
+    }
+    case Delete://DELETE FROM user WHERE id = ?
+        out.append("DELETE FROM ");
+        out.append(Table::name);
+        out.append(" WHERE ");
+        out.append(Table::columns[primaryIndex].name);
+        out.append(" = ?");
+        break;
+    case Index://CREATE INDEX IF NOT EXISTS idx_user_name ON user(name)
+        out.append("CREATE INDEX IF NOT EXISTS ");
+        out.append(indexAt<Table>(indexNo).name);
+        out.append(" ON ");
+        out.append(Table::name);
+        out.append("(");
+        out.append(indexAt<Table>(indexNo).columns);
+        out.append(")");
+        break;
+    }
+}
+
+template<class Table>
+constexpr std::size_t statementLength(Statement statement, int indexNo=0){
+    Counter counter;
+    statementWrite<Table>(counter,statement,indexNo);
+    return counter.size;
+}
+
+template<class Table>
+constexpr std::size_t indexLengthMax(){
+    std::size_t ret = 0;
+    for (int var = 0; var < indexNum<Table>(); ++var) {
+        std::size_t length = statementLength<Table>(Index,var);
+        ret = length>ret?length:ret;
+    }
+    return ret;
+}
+
+template<class Table, Statement statement>
+constexpr auto statementBuild(){
+    ESFixedString<statementLength<Table>(statement)+1> ret;
+    statementWrite<Table>(ret,statement,0);
+    return ret;
+}
+
+template<class Table>
+constexpr auto indexBuild(){
+    std::array<ESFixedString<indexLengthMax<Table>()+1>,indexNum<Table>()> ret{};
+    for (int var = 0; var < indexNum<Table>(); ++var) {
+        statementWrite<Table>(ret[var],Index,var);
+    }
+    return ret;
+}
+
+}
+
+//编译期生成的表结构常量与语句
+template<class Table>
+struct EasySQLiteSchema{
+    static constexpr int columnNum = static_cast<int>(std::size(Table::columns));
+    static constexpr int indexNum = EasySQLiteSchemaDetail::indexNum<Table>();
+    static constexpr int primarykeyIndex = EasySQLiteSchemaDetail::primarykeyIndex<Table>();
+    static_assert(primarykeyIndex>=0,"[EasySQLite/Error]编译期表结构: 未指定主键");
+
+    static constexpr int columnIndex(const char* name){
+        for (int var = 0; var < columnNum; ++var) {
+            const char* left = Table::columns[var].name;
+            const char* right = name;
+            while(*left&&*left==*right){
+                left++;
+                right++;
+            }
+            if(*left==*right){
+                return var;
+            }
+        }
+        return -1;
+    }
+
+    static constexpr auto definition = EasySQLiteSchemaDetail::statementBuild<Table,EasySQLiteSchemaDetail::Definition>();
+    static constexpr auto createSql = EasySQLiteSchemaDetail::statementBuild<Table,EasySQLiteSchemaDetail::Create>();
+    static constexpr auto insertSql = EasySQLiteSchemaDetail::statementBuild<Table,EasySQLiteSchemaDetail::Insert>();
+    static constexpr auto selectSql = EasySQLiteSchemaDetail::statementBuild<Table,EasySQLiteSchemaDetail::Select>();
+    static constexpr auto updateSql = EasySQLiteSchemaDetail::statementBuild<Table,EasySQLiteSchemaDetail::Update>();
+    static constexpr auto deleteSql = EasySQLiteSchemaDetail::statementBuild<Table,EasySQLiteSchemaDetail::Delete>();
+    static constexpr auto indexSqlList = EasySQLiteSchemaDetail::indexBuild<Table>();
+};
 
 typedef struct EasySQLiteConfig{
 private:
     QString m_databasePath="./appdata.db";
     QList<QPair<QString,QString>> tables;
     QList<QPair<QString,QString>> records;
+    bool m_memoryMode=false;
+    int m_backupInterval=60000;
+    int m_backupStepPages=256;
+    QList<QPair<QString,QString>> shardedTables;
+    QList<int> shardNums;
+    QList<QPair<QString,QString>> searchFields;
+    int m_readPoolSize=0;
+    QStringList indexes;
+    QList<QPair<QString,QString>> partitionedTables;
+    QStringList partitionFields;
+    QList<QPair<int,int>> partitionPolicies;
+    QList<QPair<QString,QString>> ttlFields;
+    QList<int> ttlSecsList;
+    int m_ttlPurgeInterval=1000;
+    int m_ttlPurgeBatch=500;
+    bool m_readOnlyMode=false;
+    bool m_immutable=false;
+    qint64 m_mmapSize=256LL*1024*1024;
+    QList<QPair<QString,QString>> compressedFields;
+    QList<int> compressThresholds;
+    QList<QPair<QString,QString>> aggregateTables;
+    QList<QPair<QStringList,QStringList>> aggregateFields;
+    int m_busyTimeout=5000;
+    int m_busyRetryNum=5;
+    int m_busyBackoff=10;
+    int m_busyBackoffMax=1000;
+    qint64 m_resultCacheSize=0;
+    int m_maintenanceInterval=0;
+    int m_maintenanceIdle=1000;
+    int m_maintenanceSlice=50;
+    qint64 m_walTruncateSize=64*1024*1024;
 
 public:
     void setDatabasePath(const QString& path){
@@ -19,14 +325,334 @@ public:
         return m_databasePath;
     }
 
+    //内存模式: 工作集在共享缓存内存数据库中 初始化时从databasePath加载 定期及析构时备份回磁盘
+    void setMemoryMode(bool enabled){
+        m_memoryMode = enabled;
+    }
+
+    bool memoryMode(){
+        return m_memoryMode;
+    }
+
+    //只读模式: 以只读方式打开并常开连接 开启mmap与query_only 跳过建表等写路径初始化 写接口直接报错
+    void setReadOnlyMode(bool enabled){
+        m_readOnlyMode = enabled;
+    }
+
+    bool readOnlyMode(){
+        return m_readOnlyMode;
+    }
+
+    //只读模式下以immutable=1打开 不加锁也不检查其他进程的修改 仅用于运行期间不会改变的文件
+    void setImmutable(bool enabled){
+        m_immutable = enabled;
+    }
+
+    bool immutable(){
+        return m_immutable;
+    }
+
+    //只读模式下的mmap_size(字节)
+    void setMmapSize(qint64 size){
+        m_mmapSize = size;
+    }
+
+    qint64 mmapSize(){
+        return m_mmapSize;
+    }
+
+    //备份间隔(毫秒) 0表示只在析构时备份
+    void setBackupInterval(int msec){
+        m_backupInterval = msec;
+    }
+
+    int backupInterval(){
+        return m_backupInterval;
+    }
+
+    //每个时间片备份的页数
+    void setBackupStepPages(int pages){
+        m_backupStepPages = pages;
+    }
+
+    int backupStepPages(){
+        return m_backupStepPages;
+    }
+
     void newTable(const QString &tableName, const QString &definition) {
         tables.append(qMakePair(tableName, definition));
     }
 
+    //用编译期表结构建表 同时登记其索引
+    template<class Table>
+    void newTable() {
+        tables.append(qMakePair(QString::fromUtf8(Table::name), EasySQLiteSchema<Table>::definition.toString()));
+        for (int indexNo = 0; indexNo < EasySQLiteSchema<Table>::indexNum; ++indexNo) {
+            indexes.append(EasySQLiteSchema<Table>::indexSqlList[indexNo].toString());
+        }
+    }
+
+    int indexNum(){
+        return indexes.size();
+    }
+
+    QString createIndexSql(int indexNo){
+        return indexes.at(indexNo);
+    }
+
     void newRecord(const QString &tableName, const QString &recordValues) {
         records.append(qMakePair(tableName, recordValues));
     }
 
+    //分片表: 按主键哈希分布到shardNum个数据库文件 文件名为 databasePath.shard序号
+    //涉及多个分片的写入在各分片内各自成一个事务 某个分片失败时其余分片已提交的部分不回滚 也不参与transactionBegin()的事务
+    //分片表的recordSelect/recordSelectTableAll结果不写入TableModel 查询后返回false 结果通过shardRecords()获取
+    void newShardedTable(const QString &tableName, const QString &definition, int shardNum) {
+        shardedTables.append(qMakePair(tableName, definition));
+        shardNums.append(shardNum);
+    }
+
+    int shardedTableNum(){
+        return shardedTables.size();
+    }
+
+    QString shardedTablename(int tableIndex){
+        return shardedTables.at(tableIndex).first;
+    }
+
+    QString shardedDefinition(int tableIndex){
+        return shardedTables.at(tableIndex).second;
+    }
+
+    int shardNum(int tableIndex){
+        return shardNums.at(tableIndex);
+    }
+
+    //按时间分区的只追加表: 每个周期一张物理表 表名_p<时间戳/周期>
+    //时间字段存放毫秒时间戳 保留最近retentionNum个分区 0表示全部保留
+    void newPartitionedTable(const QString &tableName, const QString &definition, const QString &timeFieldName,
+                             int periodSecs=86400, int retentionNum=0) {
+        partitionedTables.append(qMakePair(tableName, definition));
+        partitionFields.append(timeFieldName);
+        partitionPolicies.append(qMakePair(periodSecs, retentionNum));
+    }
+
+    int partitionedTableNum(){
+        return partitionedTables.size();
+    }
+
+    QString partitionedTablename(int tableIndex){
+        return partitionedTables.at(tableIndex).first;
+    }
+
+    QString partitionedDefinition(int tableIndex){
+        return partitionedTables.at(tableIndex).second;
+    }
+
+    QString partitionFieldname(int tableIndex){
+        return partitionFields.at(tableIndex);
+    }
+
+    int partitionPeriod(int tableIndex){
+        return partitionPolicies.at(tableIndex).first;
+    }
+
+    int partitionRetention(int tableIndex){
+        return partitionPolicies.at(tableIndex).second;
+    }
+
+    //行过期: 时间字段存放毫秒时间戳 早于当前时间ttlSecs秒的行由后台分批删除 自动为时间字段建索引
+    void newTTL(const QString &tableName, const QString &timeFieldName, int ttlSecs) {
+        ttlFields.append(qMakePair(tableName, timeFieldName));
+        ttlSecsList.append(ttlSecs);
+    }
+
+    int ttlNum(){
+        return ttlFields.size();
+    }
+
+    QString ttlTablename(int ttlIndex){
+        return ttlFields.at(ttlIndex).first;
+    }
+
+    QString ttlFieldname(int ttlIndex){
+        return ttlFields.at(ttlIndex).second;
+    }
+
+    int ttlSecs(int ttlIndex){
+        return ttlSecsList.at(ttlIndex);
+    }
+
+    //过期清理间隔(毫秒)
+    void setTTLPurgeInterval(int msec){
+        m_ttlPurgeInterval = msec;
+    }
+
+    int ttlPurgeInterval(){
+        return m_ttlPurgeInterval;
+    }
+
+    //每个事务删除的最大行数 越小写连接被占用的时间越短
+    void setTTLPurgeBatch(int rowNum){
+        m_ttlPurgeBatch = rowNum;
+    }
+
+    int ttlPurgeBatch(){
+        return m_ttlPurgeBatch;
+    }
+
+    //并行读连接池大小 大于0时主库切换为WAL模式 0表示不启用
+    void setReadPoolSize(int size){
+        m_readPoolSize = size;
+    }
+
+    int readPoolSize(){
+        return m_readPoolSize;
+    }
+
+    //压缩字段: 写入时超过threshold字节的文本/二进制值用qCompress压缩后以带标记头的BLOB存储 读取时自动解压
+    //压缩字段不能用fieldIncrement/fieldAppend在SQL中运算 也不能作为条件字段比较
+    //分片表不支持压缩字段 插入与字段更新会报错
+    void newCompressedField(const QString &tableName, const QString &fieldName, int threshold=1024) {
+        compressedFields.append(qMakePair(tableName, fieldName));
+        compressThresholds.append(threshold);
+    }
+
+    int compressedFieldNum(){
+        return compressedFields.size();
+    }
+
+    QString compressedTablename(int fieldIndex){
+        return compressedFields.at(fieldIndex).first;
+    }
+
+    QString compressedFieldname(int fieldIndex){
+        return compressedFields.at(fieldIndex).second;
+    }
+
+    int compressThreshold(int fieldIndex){
+        return compressThresholds.at(fieldIndex);
+    }
+
+    //物化聚合表: 按groupFieldNameList分组 维护行数row_count及sumFieldNameList各字段的和sum_<字段名>
+    //由源表的增删改触发器增量更新 可直接用现有查询接口读取聚合表
+    void newAggregateTable(const QString &aggregateName, const QString &sourceTableName,
+                           const QStringList &groupFieldNameList, const QStringList &sumFieldNameList=QStringList()) {
+        aggregateTables.append(qMakePair(aggregateName, sourceTableName));
+        aggregateFields.append(qMakePair(groupFieldNameList, sumFieldNameList));
+    }
+
+    int aggregateTableNum(){
+        return aggregateTables.size();
+    }
+
+    QString aggregateTablename(int tableIndex){
+        return aggregateTables.at(tableIndex).first;
+    }
+
+    QString aggregateSourcename(int tableIndex){
+        return aggregateTables.at(tableIndex).second;
+    }
+
+    QStringList aggregateGroupFields(int tableIndex){
+        return aggregateFields.at(tableIndex).first;
+    }
+
+    QStringList aggregateSumFields(int tableIndex){
+        return aggregateFields.at(tableIndex).second;
+    }
+
+    //锁竞争策略: 先由SQLite在busy_timeout(毫秒)内等待 仍为BUSY/LOCKED时按抖动指数退避重试retryNum次
+    //退避从backoff(毫秒)开始每次翻倍 不超过backoffMax
+    //分片连接使用同一策略 但其等待不计入busyStats()
+    void setBusyPolicy(int busyTimeout, int retryNum, int backoff, int backoffMax){
+        m_busyTimeout = busyTimeout;
+        m_busyRetryNum = retryNum;
+        m_busyBackoff = backoff;
+        m_busyBackoffMax = backoffMax;
+    }
+
+    int busyTimeout(){
+        return m_busyTimeout;
+    }
+
+    int busyRetryNum(){
+        return m_busyRetryNum;
+    }
+
+    int busyBackoff(){
+        return m_busyBackoff;
+    }
+
+    int busyBackoffMax(){
+        return m_busyBackoffMax;
+    }
+
+    //recordSelect查询结果缓存的内存预算(字节) 0表示不启用
+    //依赖表格被写入后缓存自动失效 只跟踪本进程内的写入
+    //TableModel经tableModel()交出后不再复用 按文本/二进制的实际大小计入预算
+    void setResultCacheSize(qint64 bytes){
+        m_resultCacheSize = bytes;
+    }
+
+    qint64 resultCacheSize(){
+        return m_resultCacheSize;
+    }
+
+    //后台维护间隔(毫秒) 每次轮流执行一项: WAL检查点/增量清理空闲页/PRAGMA optimize 0表示不启用
+    void setMaintenanceInterval(int msec){
+        m_maintenanceInterval = msec;
+    }
+
+    int maintenanceInterval(){
+        return m_maintenanceInterval;
+    }
+
+    //距最近一次SQL执行超过该时长(毫秒)才视为空闲 空闲时才执行维护
+    void setMaintenanceIdle(int msec){
+        m_maintenanceIdle = msec;
+    }
+
+    int maintenanceIdle(){
+        return m_maintenanceIdle;
+    }
+
+    //单次维护的时间片上限(毫秒)
+    void setMaintenanceSlice(int msec){
+        m_maintenanceSlice = msec;
+    }
+
+    int maintenanceSlice(){
+        return m_maintenanceSlice;
+    }
+
+    //WAL文件超过该大小(字节)时检查点改用TRUNCATE 截断WAL文件
+    void setWalTruncateSize(qint64 size){
+        m_walTruncateSize = size;
+    }
+
+    qint64 walTruncateSize(){
+        return m_walTruncateSize;
+    }
+
+    //全文检索字段: 维护trigram分词的FTS5影子表 子串/后缀条件走索引
+    //结果与LIKE一致 值中含通配符%或_时仍用LIKE 取反时不匹配NULL
+    void newSearchField(const QString &tableName, const QString &fieldName) {
+        searchFields.append(qMakePair(tableName, fieldName));
+    }
+
+    int searchFieldNum(){
+        return searchFields.size();
+    }
+
+    QString searchTablename(int fieldIndex){
+        return searchFields.at(fieldIndex).first;
+    }
+
+    QString searchFieldname(int fieldIndex){
+        return searchFields.at(fieldIndex).second;
+    }
+
     int tableNum(){
         return tables.size();
     }
@@ -52,6 +678,198 @@ public:
     }
 }ESConfig;
 
+typedef struct EasySQLiteChange{
+    enum class Operation{
+        Insert,
+        Update,
+        Delete
+    };
+
+    QString tableName;
+    Operation operation;
+    qint64 rowid;
+}ESChange;
+
+Q_DECLARE_METATYPE(EasySQLiteChange)
+
+//列式结果集: 按列连续存放 数值存定长槽 文本/BLOB统一存放在一块字符串池中 只记录偏移与长度
+typedef class EasySQLiteResultSet{
+    friend class EasySQLite;
+
+public:
+    enum class Type : quint8{
+        Null,
+        Integer,
+        Real,
+        Text,
+        Blob
+    };
+
+private:
+    struct Column{
+        QString name;
+        QList<Type> typeList;
+        QList<qint64> slotList;
+        QList<quint32> lengthList;
+    };
+
+    QList<Column> m_columnList;
+    QByteArray m_pool;
+    int m_rowNum=0;
+
+    bool load(sqlite3_stmt* statement);
+
+public:
+    int rowCount() const{
+        return m_rowNum;
+    }
+
+    int columnCount() const{
+        return m_columnList.size();
+    }
+
+    QString columnName(int column) const{
+        return m_columnList.at(column).name;
+    }
+
+    int columnIndex(const QString& name) const{
+        for (int column = 0; column < m_columnList.size(); ++column) {
+            if(m_columnList.at(column).name==name){
+                return column;
+            }
+        }
+        return -1;
+    }
+
+    Type type(int row, int column) const{
+        return m_columnList.at(column).typeList.at(row);
+    }
+
+    bool isNull(int row, int column) const{
+        return type(row,column)==Type::Null;
+    }
+
+    qint64 toInteger(int row, int column) const;
+    double toReal(int row, int column) const;
+    QStringView toText(int row, int column) const;
+    QByteArrayView toBlob(int row, int column) const;
+    QVariant value(int row, int column) const;
+
+    //整列定长槽的首地址 对应单元格为Integer时即qint64值 为Real时即double的位模式
+    const qint64* slotData(int column) const{
+        return m_columnList.at(column).slotList.constData();
+    }
+
+    qint64 memoryUsage() const;
+
+    void clear(){
+        m_columnList.clear();
+        m_pool.clear();
+        m_rowNum = 0;
+    }
+}ESResultSet;
+
+typedef struct EasySQLiteSlowQuery{
+    QDateTime time;
+    QString sql;
+    QVariantList bindValueList;
+    qint64 duration;
+    int rowNum;
+    QString plan;
+}ESSlowQuery;
+
+typedef struct EasySQLiteRead ESRead;
+typedef struct EasySQLiteReadResult ESReadResult;
+typedef struct EasySQLiteWrite ESWrite;
+typedef struct EasySQLiteTraceRecord ESTraceRecord;
+typedef struct EasySQLiteWriteResult ESWriteResult;
+
+//后台维护状态 时间为空表示尚未执行过
+typedef struct EasySQLiteMaintenanceStats{
+    qint64 freePageNum=-1;
+    qint64 pageSize=-1;
+    qint64 walSize=0;
+    qint64 vacuumPageNum=0;
+    QDateTime lastCheckpointTime;
+    QDateTime lastVacuumTime;
+    QDateTime lastOptimizeTime;
+}ESMaintenanceStats;
+
+//压缩统计 耗时单位为微秒
+typedef struct EasySQLiteCompressStats{
+    qint64 compressNum=0;
+    qint64 decompressNum=0;
+    qint64 rawBytes=0;
+    qint64 compressedBytes=0;
+    qint64 compressTime=0;
+    qint64 decompressTime=0;
+
+    //压缩后大小/原始大小 未压缩过为1
+    double ratio() const{
+        return rawBytes>0?static_cast<double>(compressedBytes)/rawBytes:1;
+    }
+}ESCompressStats;
+
+//查询结果缓存统计 内存占用为估算值
+typedef struct EasySQLiteResultCacheStats{
+    qint64 hitNum=0;
+    qint64 missNum=0;
+    qint64 staleNum=0;
+    qint64 evictNum=0;
+    int entryNum=0;
+    qint64 memoryUsage=0;
+    qint64 memoryBudget=0;
+
+    //命中率 未查询过为0
+    double hitRate() const{
+        return hitNum+missNum>0?static_cast<double>(hitNum)/(hitNum+missNum):0;
+    }
+}ESResultCacheStats;
+
+//锁等待统计 按SQL语句类型(INSERT/UPDATE/BEGIN等)分别统计 耗时单位为微秒
+typedef struct EasySQLiteBusyStats{
+    qint64 busyNum=0;
+    qint64 retryNum=0;
+    qint64 failNum=0;
+    qint64 totalWait=0;
+    qint64 maxWait=0;
+}ESBusyStats;
+
+//过期清理统计 耗时单位为微秒
+typedef struct EasySQLiteTTLStats{
+    qint64 purgeNum=0;
+    qint64 batchNum=0;
+    qint64 totalDuration=0;
+    int lastBatchNum=0;
+    qint64 lastBatchDuration=0;
+    QDateTime lastPurgeTime;
+
+    //清理速率(行/秒) 按实际删除耗时计算
+    double purgeRate() const{
+        return totalDuration>0?purgeNum*1000000.0/totalDuration:0;
+    }
+}ESTTLStats;
+
+//只读快照统计 耗时单位为毫秒
+typedef struct EasySQLiteSnapshotStats{
+    qint64 snapshotNum=0;
+    qint64 longSnapshotNum=0;
+    qint64 lastDuration=-1;
+    qint64 maxDuration=0;
+    qint64 activeDuration=-1;
+}ESSnapshotStats;
+
+//事务提交统计 耗时单位为微秒
+typedef struct EasySQLiteTransactionStats{
+    qint64 commitNum=0;
+    qint64 rollbackNum=0;
+    qint64 lastCommitDuration=-1;
+    qint64 maxCommitDuration=0;
+    qint64 totalCommitDuration=0;
+}ESTransactionStats;
+
+//依赖: 变更钩子/增量BLOB/在线备份/锁等待直接对QSQLITE驱动的连接句柄调用SQLite C API
+//Qt须以-system-sqlite编译 驱动与本程序链接同一个libsqlite3(-lsqlite3) databaseInit时核对不一致即失败
 class EasySQLite : public QObject{
     Q_OBJECT
 
@@ -78,6 +896,207 @@ private:
     bool isFieldNameMatch(const QString& tableName, const QString& fieldName, bool& isMatch);
     bool isFieldValueMatch(const QString& tableName, const QString& fieldName,
                            const QVariant& fieldValue, bool& isMatch);
+    bool fieldNameQuery(const QString& tableName, QStringList& fieldNameList);
+
+    bool m_changeNotifyEnabled=false;
+    QList<ESChange> m_changeList;
+    bool m_isChangeFlushQueued=false;
+
+    static QMutex s_changeMutex;
+    static QList<EasySQLite*> s_changeListenerList;
+    static QHash<sqlite3*,QList<ESChange>> s_pendingChangeHash;
+    static QHash<sqlite3*,QList<ESChange>> s_committingChangeHash;
+
+    static sqlite3* sqliteHandle(const QSqlDatabase& database);
+    static void updateHookCallback(void* userData, int operation, const char* databaseName,
+                                   const char* tableName, qint64 rowid);
+    static int commitHookCallback(void* userData);
+    static void rollbackHookCallback(void* userData);
+    static void changeCommitResolve(sqlite3* handle);
+    static void changeDeliver(const QList<ESChange>& changeList);
+    static QList<ESChange> changeListCoalesce(const QList<ESChange>& changeList);
+    void hookInstall();
+    void changeFlush();
+
+    bool m_memoryMode=false;
+    QString m_diskPath;
+    int m_backupStepPages=256;
+    QTimer* m_backupTimer=nullptr;
+    sqlite3* m_backupDisk=nullptr;
+    sqlite3_backup* m_backup=nullptr;
+    qint64 m_backupStartTime=0;
+    int m_backupBusyNum=0;
+    qint64 m_lastBackupDuration=-1;
+
+    bool memoryLoad();
+    bool backupBegin();
+    int backupStep(int pageNum);
+    void backupEnd(bool isSuccess);
+    void backupSlice();
+
+    int m_blobChunkSize=65536;
+
+    bool blobRowid(const QString& tableName, const QVariant& primarykeyValue, qint64& rowid);
+    bool blobStream(const QString& tableName, const QString& fieldName, qint64 rowid,
+                    QIODevice* device, bool isWrite);
+
+    QHash<QString,QStringList> m_searchFieldHash;
+
+    bool searchTableInit(const QString& tableName, const QStringList& searchFieldNameList);
+    QString searchConditionCreate(const QString& tableName, bool isSuffix, bool isNot,
+                                  const QString& condiFieldName, const QString& condiFieldValue);
+
+    struct TableSchema{
+        QStringList fieldNameList;
+        QString primarykeyName;
+    };
+    QHash<QString,TableSchema> m_schemaHash;
+
+    bool tableSchema(const QString& tableName, TableSchema& schema);
+
+    int m_readPoolSize=0;
+    QThreadPool* m_readPool=nullptr;
+    QMutex m_readHandleMutex;
+    QList<sqlite3*> m_readHandleList;
+    QList<sqlite3*> m_idleReadHandleList;
+
+    sqlite3* readHandleAcquire(QString& errorInfo);
+    void readHandleRelease(sqlite3* handle);
+    void readExec(const ESRead& read, const TableSchema& schema, ESReadResult& result);
+
+    int m_slowQueryThreshold=-1;
+    int m_slowQueryCapacity=128;
+    QString m_slowQueryFilePath;
+    QMutex m_slowQueryMutex;
+    QList<ESSlowQuery> m_slowQueryList;
+
+    bool queryExec(QSqlQuery& query, const QString& sql=QString());
+    void slowQueryRecord(const QString& sql, const QVariantList& bindValueList, qint64 duration,
+                         int rowNum, sqlite3* handle);
+    static QString slowQueryFormat(const ESSlowQuery& slowQuery);
+
+    int m_transactionDepth=0;
+    QString m_transactionTableName;
+    ESTransactionStats m_transactionStats;
+
+    bool tableModelRefresh(const QString& tableName);
+
+    bool m_readOnlyMode=false;
+    qint64 m_mmapSize=0;
+    bool isWriteRejected(const QString& title);
+
+    int m_busyTimeout=5000;
+    int m_busyRetryNum=5;
+    int m_busyBackoff=10;
+    int m_busyBackoffMax=1000;
+    QHash<QString,ESBusyStats> m_busyStatsHash;
+
+    bool busyRetryExec(QSqlQuery& query, const QString& sql, bool isTransactionControl=false);
+    static int busyHandlerCallback(void* easySQLite, int count);
+
+    QHash<QString,QHash<QString,int>> m_compressHash;
+    ESCompressStats m_compressStats;
+
+    bool isCompressedField(const QString& tableName, const QString& fieldName);
+    bool compressValue(const QString& tableName, const QString& fieldName, const QVariant& value, QByteArray& compressed);
+    QString compressedValue2SqlFormat(const QString& tableName, const QString& fieldName, const QVariant& value);
+    QString compressedValues2SqlFormat(const QString& tableName, const QVariantList& values);
+    bool decompressValue(const QString& tableName, const QString& fieldName, QVariant& value);
+    bool resultSetDecompress(const QString& tableName, ESResultSet& resultSet);
+
+    //含压缩字段表格的TableModel 读取单元格时解压 解压结果按单元格缓存
+    class CompressedTableModel : public QSqlTableModel{
+    public:
+        CompressedTableModel(EasySQLite* easySQLite, const QString& tableName, const QSqlDatabase& database);
+        QVariant data(const QModelIndex& index, int role=Qt::DisplayRole) const override;
+
+    private:
+        EasySQLite* m_easySQLite;
+        QString m_compressTableName;
+        mutable QHash<QPair<int,int>,QPair<QByteArray,QVariant>> m_decompressHash;
+    };
+
+    QSqlTableModel* tableModelCreate(const QString& tableName, QSqlQuery& query);
+
+    //物化聚合表定义
+    struct MaterializedAggregate{
+        QString sourceTableName;
+        QStringList groupFieldNameList;
+        QStringList sumFieldNameList;
+    };
+    QHash<QString,MaterializedAggregate> m_aggregateHash;
+
+    bool aggregateTableInit(const QString& aggregateName, const QString& sourceTableName,
+                            const QStringList& groupFieldNameList, const QStringList& sumFieldNameList);
+    QString aggregateFillSql(const QString& aggregateName);
+
+    //查询结果缓存条目 依赖表格的写版本与写入纪元均未变化时才命中
+    struct ResultCacheEntry{
+        QList<quint64> versionList;
+        //尚未由tableModel()交出的TableModel 交出后条目即移除
+        QPointer<QSqlTableModel> model;
+        ESResultSet resultSet;
+        qint64 cost=0;
+        quint64 lastUse=0;
+    };
+    QHash<QString,ResultCacheEntry> m_resultCacheHash;
+    qint64 m_resultCacheSize=0;
+    qint64 m_resultCacheUsage=0;
+    quint64 m_resultCacheTick=0;
+    ESResultCacheStats m_resultCacheStats;
+
+    //进程内各表格的写版本 由update钩子和写接口递增 回滚与表结构变更递增写入纪元
+    static QHash<QString,quint64> s_tableVersionHash;
+    static quint64 s_writeEpoch;
+    static int s_resultCacheNum;
+
+    static void tableVersionBump(const QString& tableName);
+    static void writeEpochBump();
+    bool isResultCacheable();
+    QList<quint64> resultCacheVersions(const QString& tableName, const QString& condition);
+    ResultCacheEntry* resultCacheFind(const QString& key, const QList<quint64>& versionList);
+    void resultCacheInsert(const QString& key, const ResultCacheEntry& entry);
+    void resultCacheEvict(const QString& key);
+
+    bool m_isSnapshot=false;
+    QElapsedTimer m_snapshotTimer;
+    int m_snapshotWarnThreshold=5000;
+    ESSnapshotStats m_snapshotStats;
+
+    enum class MaintenanceTask{
+        Checkpoint,
+        Vacuum,
+        Optimize
+    };
+    QTimer* m_maintenanceTimer=nullptr;
+    int m_maintenanceIdle=1000;
+    int m_maintenanceSlice=50;
+    qint64 m_walTruncateSize=64*1024*1024;
+    qint64 m_lastActivityTime=0;
+    MaintenanceTask m_maintenanceTask=MaintenanceTask::Checkpoint;
+    ESMaintenanceStats m_maintenanceStats;
+
+    void maintenanceSlice();
+    bool maintenanceTaskRun(MaintenanceTask task, qint64 sliceMsec);
+    QString walFilePath();
+
+    struct TTL{
+        QString timeFieldName;
+        QString keyName;
+        qint64 ttlMsec=0;
+        ESTTLStats stats;
+    };
+    QHash<QString,TTL> m_ttlHash;
+    QTimer* m_ttlTimer=nullptr;
+    int m_ttlPurgeBatch=500;
+    bool m_isTTLPurging=false;
+
+    bool ttlTableInit(const QString& tableName, const QString& timeFieldName, int ttlSecs);
+    int ttlPurgeBatch(const QString& tableName);
+    void ttlPurgeSlice();
+
+    bool fieldModify(const QString& title, const QString& tableName, const QString& fieldName, const QString& expression,
+                     const QList<QPair<QVariant,QVariant>>& primarykeyOperandList, QVariantList& newValueList);
 
 public:
     enum class Condition{
@@ -94,7 +1113,9 @@ public:
         LikeStart,
         LikeEnd,
         NotLikeStart,
-        NotLikeEnd
+        NotLikeEnd,
+        Contains,
+        NotContains
     };
 
     enum class SortPolicy{
@@ -102,6 +1123,14 @@ public:
         DESC
     };
 
+    enum class Aggregate{
+        Count,
+        Sum,
+        Avg,
+        Min,
+        Max
+    };
+
     bool databaseInit(ESConfig *config= nullptr);
     bool recordInsert(const QString& tableName, const QVariantList& values);
     bool recordsInsert(const QString& tableName, const QList<QVariantList>& valuesList);
@@ -114,11 +1143,31 @@ public:
                      const QString& condiFieldName, const QVariant& condiFieldValue);
     bool fieldUpdate(const QString& tableName, const QString& fieldName,
                      const QVariant& fieldValue,const QString& condition);
+    bool recordAggregate(const QString& tableName, const QList<QPair<Aggregate,QString>>& aggregateList,
+                         const QStringList& groupFieldNameList, const QString& condition,
+                         QList<QVariantList>& resultList);
+    bool fieldIncrement(const QString& tableName, const QVariant& primarykeyValue, const QString& fieldName,
+                        const QVariant& delta, QVariant& newValue);
+    bool fieldAppend(const QString& tableName, const QVariant& primarykeyValue, const QString& fieldName,
+                     const QVariant& suffix, QVariant& newValue);
+    bool fieldsIncrement(const QString& tableName, const QString& fieldName,
+                         const QList<QPair<QVariant,QVariant>>& primarykeyDeltaList, QVariantList& newValueList);
 
 
     QString errorInfo();
     QSqlTableModel* tableModel();
     QVariant value(const QString& tableName, const QVariant& primarykeyValue, const QString& fieldName);
+
+    enum class FetchResult{
+        Found,
+        NotFound,
+        Error
+    };
+    FetchResult recordFetch(const QString& tableName, const QVariant& primarykeyValue,
+                            const QStringList& fieldNameList, QVariantMap& row);
+    template<class Record> FetchResult recordFetch(const QString& tableName, const QVariant& primarykeyValue, Record& record);
+    bool recordsFetch(const QString& tableName, const QVariantList& primarykeyValueList, const QStringList& fieldNameList,
+                      QHash<QString,QVariantMap>& rowHash, QVariantList& missingKeyList);
     bool isValueExist(const QString& tableName, const QVariant& primarykeyValue,const QString& fieldName,const QVariant& inputValue);
     QString singleConditionCreate(const QString& tableName,const Condition& condition,
                                   const QString& condiFieldName, const QVariant& condiFieldValue);
@@ -126,7 +1175,585 @@ public:
                                   const QString& condiFieldName, const QVariantList& condiFieldValueList);
     QString mutiConditionCreate(const Condition& condition,const QStringList& conditionList);
 
+    void setChangeNotifyEnabled(bool enabled);
+    bool isChangeNotifyEnabled();
+
+    bool databaseBackup();
+    qint64 lastBackupDuration();
+
+    bool recordInsertBlob(const QString& tableName, const QVariantList& values,
+                          const QString& blobFieldName, QIODevice* device);
+    bool blobWrite(const QString& tableName, const QVariant& primarykeyValue,
+                   const QString& blobFieldName, QIODevice* device);
+    bool blobRead(const QString& tableName, const QVariant& primarykeyValue,
+                  const QString& blobFieldName, QIODevice* device);
+    void setBlobChunkSize(int size);
+
+    bool recordSelect(const QString& tableName, const QStringList& fieldNameList, const QString& condition,
+                      const QString& sortFieldName, const SortPolicy& sortPolicy, ESResultSet& resultSet);
+
+    bool readParallel(const QList<ESRead>& readList, QList<ESReadResult>& resultList);
+
+    template<class Table> bool schemaTableCreate();
+    template<class Table> bool schemaInsert(const QVariantList& values);
+    template<class Table> bool schemaSelect(const QVariant& primarykeyValue, QVariantList& values);
+    template<class Table> bool schemaUpdate(const QVariantList& values);
+    template<class Table> bool schemaDelete(const QVariant& primarykeyValue);
+
+    void setSlowQueryThreshold(int msec);
+    void setSlowQueryCapacity(int capacity);
+    void setSlowQueryFile(const QString& filePath);
+    QList<ESSlowQuery> slowQueries();
+    QString slowQueryDump(bool isClear=false);
+
+    bool transactionBegin();
+    bool transactionCommit();
+    bool transactionRollback();
+    int transactionDepth();
+    bool writeBatch(const QList<ESWrite>& writeList, QList<ESWriteResult>& resultList);
+    ESTransactionStats transactionStats();
+
+    bool snapshotBegin();
+    bool snapshotEnd();
+    bool isInSnapshot();
+    void setSnapshotWarnThreshold(int msec);
+    ESSnapshotStats snapshotStats();
+
+    bool maintenanceRun();
+    ESMaintenanceStats maintenanceStats();
+
+    enum class TraceMethod:quint8{
+        RecordInsert,
+        RecordsInsert,
+        RecordDelete,
+        RecordsDelete,
+        RecordSelectTableAll,
+        RecordSelect,
+        FieldUpdateValue,
+        FieldUpdate,
+        Value,
+        IsValueExist,
+        FieldIncrement,
+        FieldAppend,
+        FieldsIncrement,
+        RecordAggregate,
+        RecordFetch,
+        RecordsFetch,
+        RecordSelectResultSet,
+        RecordInsertBlob,
+        BlobWrite,
+        BlobRead,
+        ReadParallel,
+        TransactionBegin,
+        TransactionCommit,
+        TransactionRollback,
+        WriteBatch,
+        SnapshotBegin,
+        SnapshotEnd,
+        PartitionDrop,
+        AggregateRebuild,
+        SchemaExec
+    };
+    bool traceStart(const QString& filePath);
+    void traceStop();
+    static bool traceLoad(const QString& filePath, QList<ESTraceRecord>& recordList, QString& errorInfo, ESConfig* config=nullptr);
+    bool traceReplay(const ESTraceRecord& record);
+
+    ESTTLStats ttlStats(const QString& tableName);
+    QHash<QString,ESBusyStats> busyStats();
+    ESCompressStats compressStats();
+
+    bool isShardedTable(const QString& tableName);
+    QList<QVariantList> shardRecords();
+    QStringList shardFieldNames();
+
+    bool isPartitionedTable(const QString& tableName);
+    QStringList partitionNames(const QString& tableName);
+    bool partitionDrop(const QString& tableName, qint64 beforeMsec);
+
+    bool isAggregateTable(const QString& tableName);
+    bool aggregateRebuild(const QString& aggregateName);
+
+    ESResultCacheStats resultCacheStats();
+    void resultCacheClear();
+
+signals:
+    void recordsChanged(const QList<ESChange>& changeList);
+    void backupProgress(int remainingPages, int totalPages);
+    void backupFinished(bool isSuccess, qint64 msec);
+
+private:
+    struct ShardTask{
+        int shardIndex=0;
+        QStringList sqlList;
+        bool isSelect=false;
+        QList<QVariantList> rowList;
+        int affectedNum=0;
+        bool isSuccess=false;
+        QString errorInfo;
+    };
+
+    QStringList m_shardPathList;
+    QHash<QString,int> m_shardNumHash;
+    QHash<QString,QStringList> m_shardFieldNameHash;
+    QHash<QString,QString> m_shardPrimarykeyHash;
+    QList<QVariantList> m_shardRecordList;
+    QStringList m_shardRecordFieldNameList;
+
+    bool shardTableInit(const QString& tableName, const QString& definition, int shardNum);
+    QString shardConnectionName(int shardIndex);
+    QSqlDatabase shardDatabase(int shardIndex);
+    static int shardIndex(const QVariant& primarykeyValue, int shardNum);
+    static bool shardValueLess(const QVariant& left, const QVariant& right);
+    void shardSqlExec(QSqlDatabase& database, ShardTask& task);
+    void shardTaskRun(const QString& path, ShardTask* task);
+    bool shardTaskListRun(QList<ShardTask>& taskList);
+    void shardRecordMerge(const QList<ShardTask>& taskList, int sortIndex, const SortPolicy& sortPolicy);
+    bool shardRecordInsert(const QString& tableName, const QList<QVariantList>& valuesList);
+    bool shardRecordDelete(const QString& tableName, const QVariantList& primarykeyValueList);
+    bool shardRecordSelect(const QString& tableName, const QStringList& fieldNameList, const QString& condition,
+                           const QString& sortFieldName, const SortPolicy& sortPolicy);
+    bool shardFieldUpdate(const QString& tableName, const QString& fieldName, const QVariant& fieldValue,
+                          const QString& condition, const QVariant& primarykeyValue);
+    bool shardValue(const QString& tableName, const QVariant& primarykeyValue, const QString& fieldName, QVariant& value);
+
+    //记录一次公开调用 只记录最外层调用 内部互相调用不重复记录
+    class TraceScope{
+    public:
+        template<class... Args>
+        TraceScope(EasySQLite* easySQLite, TraceMethod method, const QString& tableName, const Args&... args)
+            :m_easySQLite(easySQLite),m_method(method){
+            m_isActive = m_easySQLite->m_traceFile!=nullptr&&m_easySQLite->m_traceDepth==0;
+            m_easySQLite->m_traceDepth++;
+            if(m_isActive){
+                m_tableName = tableName;
+                m_argList = QVariantList{traceArg(args)...};
+                m_startTime = m_easySQLite->m_traceTimer.nsecsElapsed()/1000;
+            }
+        }
+        ~TraceScope();
+
+    private:
+        EasySQLite* m_easySQLite;
+        TraceMethod m_method;
+        bool m_isActive;
+        QString m_tableName;
+        QVariantList m_argList;
+        qint64 m_startTime=0;
+    };
+
+    QFile* m_traceFile=nullptr;
+    QDataStream* m_traceStream=nullptr;
+    QElapsedTimer m_traceTimer;
+    int m_traceDepth=0;
+    QVariantMap m_traceConfig;
+
+    static QVariantMap traceConfigSave(ESConfig* config);
+    static void traceConfigApply(const QVariantMap& configMap, ESConfig* config);
+
+    static QVariant traceArg(const QVariant& arg);
+    static QVariant traceArg(const QList<QVariantList>& arg);
+    static QVariant traceArg(const SortPolicy& arg);
+    static QVariant traceArg(const QList<QPair<Aggregate,QString>>& arg);
+    static QVariant traceArg(const QList<QPair<QVariant,QVariant>>& arg);
+    static QVariant traceArg(QIODevice* arg);
+    static QVariant traceArg(const QList<ESWrite>& arg);
+    static QVariant traceArg(const QList<ESRead>& arg);
+
+    struct Partition{
+        QString definition;
+        QString timeFieldName;
+        int timeFieldIndex=-1;
+        qint64 periodMsec=0;
+        int retentionNum=0;
+        QStringList fieldNameList;
+        QList<qint64> partitionList;
+    };
+
+    QHash<QString,Partition> m_partitionHash;
+
+    bool partitionTableInit(const QString& tableName, const QString& definition, const QString& timeFieldName,
+                            int periodSecs, int retentionNum);
+    static QString partitionName(const QString& tableName, qint64 partitionNo);
+    bool partitionEnsure(const QString& tableName, qint64 partitionNo);
+    bool partitionListLoad(const QString& tableName);
+    void partitionListReload();
+    static void partitionRange(const QString& timeFieldName, const QString& condition, qint64& lower, qint64& upper);
+    bool partitionRecordInsert(const QString& tableName, const QList<QVariantList>& valuesList);
+    bool partitionRecordSelect(const QString& tableName, const QStringList& fieldNameList, const QString& condition,
+                               const QString& sortFieldName, const SortPolicy& sortPolicy);
 
 };
 
+//并行读操作: Select读入结果集 Value按主键取单个字段
+typedef struct EasySQLiteRead{
+    enum class Kind{
+        Select,
+        Value
+    };
+
+    Kind kind=Kind::Select;
+    QString tableName;
+    QStringList fieldNameList;
+    QString condition;
+    QString sortFieldName;
+    EasySQLite::SortPolicy sortPolicy=EasySQLite::SortPolicy::ASC;
+    QVariant primarykeyValue;
+
+    static EasySQLiteRead select(const QString& tableName, const QStringList& fieldNameList, const QString& condition,
+                                 const QString& sortFieldName, EasySQLite::SortPolicy sortPolicy){
+        EasySQLiteRead read;
+        read.kind = Kind::Select;
+        read.tableName = tableName;
+        read.fieldNameList = fieldNameList;
+        read.condition = condition;
+        read.sortFieldName = sortFieldName;
+        read.sortPolicy = sortPolicy;
+        return read;
+    }
+
+    static EasySQLiteRead value(const QString& tableName, const QVariant& primarykeyValue, const QString& fieldName){
+        EasySQLiteRead read;
+        read.kind = Kind::Value;
+        read.tableName = tableName;
+        read.fieldNameList = QStringList{fieldName};
+        read.primarykeyValue = primarykeyValue;
+        return read;
+    }
+}ESRead;
+
+typedef struct EasySQLiteReadResult{
+    bool isSuccess=false;
+    QString errorInfo;
+    QVariant value;
+    ESResultSet resultSet;
+}ESReadResult;
+
+//批量写操作 writeBatch()在同一事务中按顺序执行
+typedef struct EasySQLiteWrite{
+    enum class Kind{
+        Insert,
+        Update,
+        Delete,
+        Upsert
+    };
+
+    Kind kind=Kind::Insert;
+    QString tableName;
+    QStringList fieldNameList;
+    QVariantList values;
+    QVariant primarykeyValue;
+
+    //插入整行
+    static EasySQLiteWrite insert(const QString& tableName, const QVariantList& values){
+        EasySQLiteWrite write;
+        write.kind = Kind::Insert;
+        write.tableName = tableName;
+        write.values = values;
+        return write;
+    }
+
+    //按主键更新若干字段
+    static EasySQLiteWrite update(const QString& tableName, const QVariant& primarykeyValue,
+                                  const QStringList& fieldNameList, const QVariantList& values){
+        EasySQLiteWrite write;
+        write.kind = Kind::Update;
+        write.tableName = tableName;
+        write.primarykeyValue = primarykeyValue;
+        write.fieldNameList = fieldNameList;
+        write.values = values;
+        return write;
+    }
+
+    //按主键删除
+    static EasySQLiteWrite remove(const QString& tableName, const QVariant& primarykeyValue){
+        EasySQLiteWrite write;
+        write.kind = Kind::Delete;
+        write.tableName = tableName;
+        write.primarykeyValue = primarykeyValue;
+        return write;
+    }
+
+    //插入整行 主键冲突时更新其余字段
+    static EasySQLiteWrite upsert(const QString& tableName, const QVariantList& values){
+        EasySQLiteWrite write;
+        write.kind = Kind::Upsert;
+        write.tableName = tableName;
+        write.values = values;
+        return write;
+    }
+}ESWrite;
+
+typedef struct EasySQLiteWriteResult{
+    bool isSuccess=false;
+    QString errorInfo;
+    int affectedNum=0;
+}ESWriteResult;
+
+//只读快照作用域守卫 构造时开启快照 析构时释放
+//首次开启快照会把数据库文件永久切换为WAL模式 见snapshotBegin()
+typedef class EasySQLiteSnapshot{
+public:
+    explicit EasySQLiteSnapshot(EasySQLite* easySQLite);
+    ~EasySQLiteSnapshot();
+    EasySQLiteSnapshot(const EasySQLiteSnapshot&) = delete;
+    EasySQLiteSnapshot& operator=(const EasySQLiteSnapshot&) = delete;
+
+    bool isActive();
+
+private:
+    EasySQLite* m_easySQLite;
+    bool m_isActive;
+}ESSnapshot;
+
+//操作轨迹中的一次调用 时间单位为微秒 起始时间相对于开始记录的时刻
+typedef struct EasySQLiteTraceRecord{
+    EasySQLite::TraceMethod method=EasySQLite::TraceMethod::RecordInsert;
+    qint64 startTime=0;
+    qint64 duration=0;
+    QString tableName;
+    QVariantList argList;
+}ESTraceRecord;
+
+//事务作用域守卫 构造时开启事务(嵌套时为保存点) 析构时若未提交则回滚
+typedef class EasySQLiteTransaction{
+public:
+    explicit EasySQLiteTransaction(EasySQLite* easySQLite);
+    ~EasySQLiteTransaction();
+    EasySQLiteTransaction(const EasySQLiteTransaction&) = delete;
+    EasySQLiteTransaction& operator=(const EasySQLiteTransaction&) = delete;
+
+    bool isActive();
+    bool commit();
+    bool rollback();
+
+private:
+    EasySQLite* m_easySQLite;
+    bool m_isActive;
+}ESTransaction;
+
+/*
+ *  @brief  按主键读取整行并转换为结构体
+ *          Record需提供static QStringList fieldNames()与static Record fromMap(const QVariantMap&)
+ *  @param  表格名
+ *  @param  主键值
+ *  @param  结构体(输出) 仅在Found时赋值
+ *  @retval Found/NotFound/Error
+ */
+template<class Record>
+EasySQLite::FetchResult EasySQLite::recordFetch(const QString &tableName, const QVariant &primarykeyValue, Record &record){
+    QVariantMap row;
+    FetchResult ret = recordFetch(tableName,primarykeyValue,Record::fieldNames(),row);
+    if(ret==FetchResult::Found){
+        record = Record::fromMap(row);
+    }
+    return ret;
+}
+
+/*
+ *  @brief  用编译期表结构建表及索引 已存在时跳过
+ *  @param  无
+ *  @retval 是否建表成功
+ */
+template<class Table>
+bool EasySQLite::schemaTableCreate(){
+    //按生成的SQL语句记录 重放时不依赖编译期类型
+    QStringList sqlList{EasySQLiteSchema<Table>::createSql.toString()};
+    for (int indexNo = 0; indexNo < EasySQLiteSchema<Table>::indexNum; ++indexNo) {
+        sqlList.append(EasySQLiteSchema<Table>::indexSqlList[indexNo].toString());
+    }
+    TraceScope trace(this,TraceMethod::SchemaExec,QString::fromUtf8(Table::name),sqlList,QVariantList());
+
+    if(isWriteRejected("编译期建表")){
+        return false;
+    }
+    if(!m_database.isOpen()&&!databaseOpen()){
+        m_errorInfo = "[EasySQLite/Error]编译期建表报错: 数据库打开失败";
+        return false;
+    }
+
+    QSqlQuery query;
+    if(!queryExec(query,EasySQLiteSchema<Table>::createSql.toString())){
+        m_errorInfo = "[EasySQLite/Error]编译期建表报错: 执行SQL语句建表错误" + query.lastError().text();
+        return false;
+    }
+    for (int indexNo = 0; indexNo < EasySQLiteSchema<Table>::indexNum; ++indexNo) {
+        if(!queryExec(query,EasySQLiteSchema<Table>::indexSqlList[indexNo].toString())){
+            m_errorInfo = "[EasySQLite/Error]编译期建表报错: 执行SQL语句建索引错误" + query.lastError().text();
+            return false;
+        }
+    }
+
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  按编译期表结构插入整行记录 不查询表结构 不刷新TableModel
+ *  @param  按列顺序排列的数据
+ *  @retval 是否插入成功
+ */
+template<class Table>
+bool EasySQLite::schemaInsert(const QVariantList &values){
+    TraceScope trace(this,TraceMethod::SchemaExec,QString::fromUtf8(Table::name),
+                     QStringList{EasySQLiteSchema<Table>::insertSql.toString()},values);
+
+    if(isWriteRejected("编译期插入")){
+        return false;
+    }
+    if(values.size()!=EasySQLiteSchema<Table>::columnNum){
+        m_errorInfo = "[EasySQLite/Error]编译期插入报错: 数据个数与列数不一致";
+        return false;
+    }
+    if(!m_database.isOpen()&&!databaseOpen()){
+        m_errorInfo = "[EasySQLite/Error]编译期插入报错: 数据库打开失败";
+        return false;
+    }
+
+    QSqlQuery query;
+    query.prepare(EasySQLiteSchema<Table>::insertSql.toString());
+    for (int var = 0; var < values.size(); ++var) {
+        query.addBindValue(values.at(var));
+    }
+    if(!queryExec(query)){
+        m_errorInfo = "[EasySQLite/Error]编译期插入报错: 执行SQL语句插入数据错误" + query.lastError().text();
+        return false;
+    }
+
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  按主键读取整行 列下标可用EasySQLiteSchema<Table>::columnIndex()在编译期得到
+ *  @param  主键值
+ *  @param  按列顺序排列的数据(输出)
+ *  @retval 是否读取成功 主键值不存在视为失败
+ */
+template<class Table>
+bool EasySQLite::schemaSelect(const QVariant &primarykeyValue, QVariantList &values){
+    TraceScope trace(this,TraceMethod::SchemaExec,QString::fromUtf8(Table::name),
+                     QStringList{EasySQLiteSchema<Table>::selectSql.toString()},QVariantList{primarykeyValue});
+
+    if(!m_database.isOpen()&&!databaseOpen()){
+        m_errorInfo = "[EasySQLite/Error]编译期查询报错: 数据库打开失败";
+        return false;
+    }
+
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.prepare(EasySQLiteSchema<Table>::selectSql.toString());
+    query.addBindValue(primarykeyValue);
+    if(!queryExec(query)){
+        m_errorInfo = "[EasySQLite/Error]编译期查询报错: 执行SQL语句查询错误" + query.lastError().text();
+        return false;
+    }
+    if(!query.next()){
+        m_errorInfo = "[EasySQLite/Error]编译期查询报错: 主键值不存在";
+        return false;
+    }
+
+    //压缩字段解压
+    values.clear();
+    values.reserve(EasySQLiteSchema<Table>::columnNum);
+    for (int var = 0; var < EasySQLiteSchema<Table>::columnNum; ++var) {
+        QVariant value = query.value(var);
+        if(!decompressValue(QString::fromUtf8(Table::name),QString::fromUtf8(Table::columns[var].name),value)){
+            values.clear();
+            return false;
+        }
+        values.append(value);
+    }
+
+    query.finish();
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  按主键更新整行 主键取自values中主键列的值
+ *  @param  按列顺序排列的数据
+ *  @retval 是否更新成功 主键值不存在视为失败
+ */
+template<class Table>
+bool EasySQLite::schemaUpdate(const QVariantList &values){
+    //只有主键列时生成的UPDATE语句SET为空
+    static_assert(EasySQLiteSchema<Table>::columnNum>1,"[EasySQLite/Error]编译期更新: 表格只有主键列 没有可更新的列");
+
+    //绑定顺序为非主键列在前 主键在后
+    QVariantList bindList = values;
+    if(bindList.size()==EasySQLiteSchema<Table>::columnNum){
+        bindList.move(EasySQLiteSchema<Table>::primarykeyIndex,bindList.size()-1);
+    }
+    TraceScope trace(this,TraceMethod::SchemaExec,QString::fromUtf8(Table::name),
+                     QStringList{EasySQLiteSchema<Table>::updateSql.toString()},bindList);
+
+    if(isWriteRejected("编译期更新")){
+        return false;
+    }
+    if(values.size()!=EasySQLiteSchema<Table>::columnNum){
+        m_errorInfo = "[EasySQLite/Error]编译期更新报错: 数据个数与列数不一致";
+        return false;
+    }
+    if(!m_database.isOpen()&&!databaseOpen()){
+        m_errorInfo = "[EasySQLite/Error]编译期更新报错: 数据库打开失败";
+        return false;
+    }
+
+    //非主键列依次绑定 最后绑定主键
+    QSqlQuery query;
+    query.prepare(EasySQLiteSchema<Table>::updateSql.toString());
+    for (int var = 0; var < values.size(); ++var) {
+        if(var!=EasySQLiteSchema<Table>::primarykeyIndex){
+            query.addBindValue(values.at(var));
+        }
+    }
+    query.addBindValue(values.at(EasySQLiteSchema<Table>::primarykeyIndex));
+    if(!queryExec(query)){
+        m_errorInfo = "[EasySQLite/Error]编译期更新报错: 执行SQL语句更新数据错误" + query.lastError().text();
+        return false;
+    }
+    if(query.numRowsAffected()==0){
+        m_errorInfo = "[EasySQLite/Error]编译期更新报错: 主键值不存在";
+        return false;
+    }
+
+    databaseClose();
+    return true;
+}
+
+/*
+ *  @brief  按主键删除整行
+ *  @param  主键值
+ *  @retval 是否删除成功 主键值不存在视为失败
+ */
+template<class Table>
+bool EasySQLite::schemaDelete(const QVariant &primarykeyValue){
+    TraceScope trace(this,TraceMethod::SchemaExec,QString::fromUtf8(Table::name),
+                     QStringList{EasySQLiteSchema<Table>::deleteSql.toString()},QVariantList{primarykeyValue});
+
+    if(isWriteRejected("编译期删除")){
+        return false;
+    }
+    if(!m_database.isOpen()&&!databaseOpen()){
+        m_errorInfo = "[EasySQLite/Error]编译期删除报错: 数据库打开失败";
+        return false;
+    }
+
+    QSqlQuery query;
+    query.prepare(EasySQLiteSchema<Table>::deleteSql.toString());
+    query.addBindValue(primarykeyValue);
+    if(!queryExec(query)){
+        m_errorInfo = "[EasySQLite/Error]编译期删除报错: 执行SQL语句删除记录错误" + query.lastError().text();
+        return false;
+    }
+    if(query.numRowsAffected()==0){
+        m_errorInfo = "[EasySQLite/Error]编译期删除报错: 主键值不存在";
+        return false;
+    }
+
+    databaseClose();
+    return true;
+}
+
 #endif // EASYSQLITE_H
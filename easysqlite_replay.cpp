@@ -0,0 +1,248 @@
+/*
+ *  EasySQLite轨迹重放工具
+ *  用法: easysqlite_replay <轨迹文件> <数据库文件> [--fast] [--threads N]
+ *  在数据库文件的副本上重放EasySQLite::traceStart()记录的调用 输出吞吐量与延迟分位数
+ *  默认按记录时的节奏重放 --fast为尽快重放
+ *  EasySQLite使用进程内默认连接 --threads N>1时启动N个子进程 按调用序号轮流分配记录 共用同一副本
+ *  轨迹含事务控制或快照调用时 多进程会把同一事务拆到不同进程 请用单进程重放
+ *  按轨迹文件头记录的配置重新登记读连接池/分片/分区/过期/压缩等 分片文件一并复制
+ *  构建见easysqlite_replay.pro
+ */
+#include "easysqlite.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QTextStream>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+
+//单次重放结果
+struct ReplayResult{
+    int method=0;
+    qint64 latency=0;
+    bool isSuccess=false;
+};
+
+static const char* s_methodNameList[] = {
+    "recordInsert","recordsInsert","recordDelete","recordsDelete","recordSelectTableAll","recordSelect",
+    "fieldUpdateValue","fieldUpdate","value","isValueExist","fieldIncrement","fieldAppend",
+    "fieldsIncrement","recordAggregate","recordFetch","recordsFetch","recordSelect(ESResultSet)",
+    "recordInsertBlob","blobWrite","blobRead","readParallel",
+    "transactionBegin","transactionCommit","transactionRollback","writeBatch",
+    "snapshotBegin","snapshotEnd","partitionDrop","aggregateRebuild","schemaExec"
+};
+
+/*
+ *  @brief  重放分配给本进程的记录
+ *  @param  副本数据库路径
+ *  @param  轨迹记录时的配置
+ *  @param  调用记录列表
+ *  @param  进程序号
+ *  @param  进程总数
+ *  @param  是否尽快重放
+ *  @param  重放结果列表(输出)
+ *  @retval 是否初始化成功
+ */
+static bool replayRun(const QString& databasePath, const ESConfig& traceConfig, const QList<ESTraceRecord>& recordList,
+                      int workerIndex, int workerNum, bool isFast, QList<ReplayResult>& resultList){
+    EasySQLite easySQLite;
+    ESConfig config = traceConfig;
+    config.setDatabasePath(databasePath);
+    if(!easySQLite.databaseInit(&config)){
+        qDebug().noquote()<<easySQLite.errorInfo();
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int var = workerIndex; var < recordList.size(); var += workerNum) {
+        const ESTraceRecord& record = recordList.at(var);
+        //按记录时的节奏 等到调用时刻再执行
+        if(!isFast){
+            qint64 wait = record.startTime-timer.nsecsElapsed()/1000;
+            if(wait>0){
+                QThread::usleep(static_cast<unsigned long>(wait));
+            }
+        }
+        QElapsedTimer callTimer;
+        callTimer.start();
+        ReplayResult result;
+        result.isSuccess = easySQLite.traceReplay(record);
+        result.latency = callTimer.nsecsElapsed()/1000;
+        result.method = static_cast<int>(record.method);
+        resultList.append(result);
+    }
+    return true;
+}
+
+/*
+ *  @brief  取已排序延迟列表的分位数
+ *  @param  已排序的延迟列表
+ *  @param  分位(0~1)
+ *  @retval 延迟(微秒)
+ */
+static qint64 percentile(const QList<qint64>& sortedList, double rank){
+    if(sortedList.isEmpty()){
+        return 0;
+    }
+    qsizetype index = static_cast<qsizetype>(rank*(sortedList.size()-1)+0.5);
+    return sortedList.at(qMin(index,sortedList.size()-1));
+}
+
+/*
+ *  @brief  打印吞吐量与延迟分位数
+ *  @param  重放结果列表
+ *  @param  总耗时(微秒)
+ *  @retval 无
+ */
+static void replayReport(const QList<ReplayResult>& resultList, qint64 wallTime){
+    QTextStream out(stdout);
+    QList<qint64> latencyList;
+    QList<QList<qint64>> methodLatencyList(std::size(s_methodNameList));
+    int failNum = 0;
+    for (int var = 0; var < resultList.size(); ++var) {
+        const ReplayResult& result = resultList.at(var);
+        latencyList.append(result.latency);
+        if(result.method>=0&&result.method<methodLatencyList.size()){
+            methodLatencyList[result.method].append(result.latency);
+        }
+        if(!result.isSuccess){
+            failNum++;
+        }
+    }
+    std::sort(latencyList.begin(),latencyList.end());
+
+    double seconds = wallTime/1000000.0;
+    out<<QString("calls %1  failed %2  wall %3 s  throughput %4 ops/s\n")
+               .arg(resultList.size()).arg(failNum).arg(seconds,0,'f',3)
+               .arg(seconds>0?resultList.size()/seconds:0.0,0,'f',1);
+    out<<QString("latency(us) p50 %1  p90 %2  p99 %3  p99.9 %4  max %5\n")
+               .arg(percentile(latencyList,0.5)).arg(percentile(latencyList,0.9)).arg(percentile(latencyList,0.99))
+               .arg(percentile(latencyList,0.999)).arg(latencyList.isEmpty()?0:latencyList.last());
+    for (int method = 0; method < methodLatencyList.size(); ++method) {
+        QList<qint64>& methodList = methodLatencyList[method];
+        if(methodList.isEmpty()){
+            continue;
+        }
+        std::sort(methodList.begin(),methodList.end());
+        out<<QString("  %1 calls %2  p50 %3  p99 %4\n").arg(QString::fromLatin1(s_methodNameList[method]),-22)
+                   .arg(methodList.size()).arg(percentile(methodList,0.5)).arg(percentile(methodList,0.99));
+    }
+}
+
+int main(int argc, char *argv[]){
+    QCoreApplication app(argc,argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replay an EasySQLite trace against a copy of a database");
+    parser.addHelpOption();
+    parser.addPositionalArgument("trace","trace file written by EasySQLite::traceStart()");
+    parser.addPositionalArgument("database","database file to copy and replay against");
+    QCommandLineOption fastOption("fast","replay as fast as possible instead of at recorded pacing");
+    QCommandLineOption threadsOption("threads","number of replay processes","N","1");
+    QCommandLineOption workerOption("worker","internal: replay as worker process","index");
+    workerOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    parser.addOption(fastOption);
+    parser.addOption(threadsOption);
+    parser.addOption(workerOption);
+    parser.process(app);
+
+    const QStringList positionalList = parser.positionalArguments();
+    if(positionalList.size()!=2){
+        parser.showHelp(1);
+    }
+    QString tracePath = positionalList.at(0);
+    QString databasePath = positionalList.at(1);
+    bool isFast = parser.isSet(fastOption);
+    int workerNum = qMax(1,parser.value(threadsOption).toInt());
+
+    QList<ESTraceRecord> recordList;
+    QString errorInfo;
+    ESConfig traceConfig;
+    if(!EasySQLite::traceLoad(tracePath,recordList,errorInfo,&traceConfig)){
+        qDebug().noquote()<<errorInfo;
+        return 1;
+    }
+
+    //子进程 在父进程准备好的副本上重放 每行输出: 方法 延迟 是否成功
+    if(parser.isSet(workerOption)){
+        QList<ReplayResult> resultList;
+        if(!replayRun(databasePath,traceConfig,recordList,parser.value(workerOption).toInt(),workerNum,isFast,resultList)){
+            return 1;
+        }
+        QTextStream out(stdout);
+        for (int var = 0; var < resultList.size(); ++var) {
+            out<<resultList.at(var).method<<' '<<resultList.at(var).latency<<' '<<int(resultList.at(var).isSuccess)<<'\n';
+        }
+        return 0;
+    }
+
+    //在副本上重放 不改动原数据库
+    QString copyPath = databasePath + ".replay";
+    QFile::remove(copyPath);
+    QFile::remove(copyPath + "-wal");
+    QFile::remove(copyPath + "-shm");
+    if(!QFile::copy(databasePath,copyPath)){
+        qDebug().noquote()<<"[EasySQLite/Error]轨迹重放报错: 数据库副本创建失败";
+        return 1;
+    }
+    //分片文件与主库同名加.shard序号 一并复制
+    int shardFileNum = 0;
+    for (int tableIndex = 0; tableIndex < traceConfig.shardedTableNum(); ++tableIndex) {
+        shardFileNum = qMax(shardFileNum,traceConfig.shardNum(tableIndex));
+    }
+    for (int shardIndex = 0; shardIndex < shardFileNum; ++shardIndex) {
+        QString shardPath = QString("%1.shard%2").arg(databasePath).arg(shardIndex);
+        QString shardCopyPath = QString("%1.shard%2").arg(copyPath).arg(shardIndex);
+        QFile::remove(shardCopyPath);
+        if(QFile::exists(shardPath)&&!QFile::copy(shardPath,shardCopyPath)){
+            qDebug().noquote()<<"[EasySQLite/Error]轨迹重放报错: 分片文件副本创建失败";
+            return 1;
+        }
+    }
+    QTextStream(stdout)<<QString("replaying %1 calls on %2 (%3, %4 process)\n").arg(recordList.size()).arg(copyPath)
+                              .arg(isFast?"fast":"paced").arg(workerNum);
+
+    QList<ReplayResult> resultList;
+    QElapsedTimer timer;
+    timer.start();
+    if(workerNum==1){
+        if(!replayRun(copyPath,traceConfig,recordList,0,1,isFast,resultList)){
+            return 1;
+        }
+    }else{
+        QList<QProcess*> processList;
+        for (int workerIndex = 0; workerIndex < workerNum; ++workerIndex) {
+            QProcess* process = new QProcess(&app);
+            QStringList argumentList{tracePath,copyPath,"--threads",QString::number(workerNum),
+                                     "--worker",QString::number(workerIndex)};
+            if(isFast){
+                argumentList.append("--fast");
+            }
+            process->start(QCoreApplication::applicationFilePath(),argumentList);
+            processList.append(process);
+        }
+        for (int workerIndex = 0; workerIndex < processList.size(); ++workerIndex) {
+            QProcess* process = processList.at(workerIndex);
+            process->waitForFinished(-1);
+            const QList<QByteArray> lineList = process->readAllStandardOutput().split('\n');
+            for (int var = 0; var < lineList.size(); ++var) {
+                const QList<QByteArray> fieldList = lineList.at(var).trimmed().split(' ');
+                if(fieldList.size()!=3){
+                    continue;
+                }
+                ReplayResult result;
+                result.method = fieldList.at(0).toInt();
+                result.latency = fieldList.at(1).toLongLong();
+                result.isSuccess = fieldList.at(2).toInt()!=0;
+                resultList.append(result);
+            }
+        }
+    }
+    replayReport(resultList,timer.nsecsElapsed()/1000);
+    return 0;
+}
@@ -0,0 +1,20 @@
+# EasySQLite轨迹重放工具
+# 构建: qmake easysqlite_replay.pro && make
+QT += core sql concurrent
+QT -= gui
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = easysqlite_replay
+
+SOURCES += \
+    easysqlite.cpp \
+    easysqlite_replay.cpp
+
+HEADERS += \
+    easysqlite.h
+
+# 钩子 增量BLOB 在线备份等接口直接对QSQLITE驱动的连接句柄调用SQLite C API
+# Qt须以 -system-sqlite 编译 使驱动与本程序链接同一个libsqlite3 否则databaseInit报错
+LIBS += -lsqlite3